@@ -26,6 +26,21 @@ THE SOFTWARE.
 #include <QMessageBox>
 #include "memory.hxx"
 #include "gdb-remote.hxx"
+#include "metrics.hxx"
+#include "trace.hxx"
+
+/* if nonzero, the 'QStartNoAckMode' extension is used, if supported by the probe */
+#define NO_ACK_MODE_ENABLED	1
+/* the time to wait for the probe to respond while connecting, in milliseconds */
+#define HANDSHAKE_TIMEOUT_MS	1000
+/* if nonzero, the binary memory read ('x') request is used, if supported by the probe */
+#define BINARY_READS_ENABLED	1
+/* the maximum number of bytes read with a single hex encoded memory read ('m') request, if the probe does not report
+ * its maximum packet size */
+#define DEFAULT_MAX_HEX_READ_SIZE	1000
+/* the maximum number of memory read requests sent to the probe before collecting their replies, when reading
+ * scattered memory ranges */
+#define MAX_PIPELINED_READ_REQUESTS	16
 
 void Blackmagic::readAllRegisters(void)
 {
@@ -38,88 +53,192 @@ void Blackmagic::readAllRegisters(void)
 
 void Blackmagic::putPacket(const QByteArray &request)
 {
-char c;
-	port->write(request);
-	if (!port->waitForBytesWritten(1000))
-		Util::panic();
-	while ((c = getChar()) != '+')
-		qDebug() << "!!!!!" << c;//Util::panic();
+static Metrics::Histogram & put_time(Metrics::histogram("blackmagic.packet-put"));
+static Metrics::Counter & packets(Metrics::counter("blackmagic.packets-sent"));
+static Metrics::Counter & bytes(Metrics::counter("blackmagic.bytes-sent"));
+Metrics::ScopedTimer timer(put_time);
+TRACE_SPAN_CATEGORY("Blackmagic::putPacket", "probe");
+	packets.increment();
+	bytes.increment(request.length());
+	request_timer.start();
+	link->putPacket(request);
 }
 
 QByteArray Blackmagic::getPacket()
 {
-QByteArray packet("$");
-	while (getChar() != '$')
-		;
-	while (1)
-	{
-		packet += getChar();
-		if (packet[packet.length() - 1] == '#')
-			break;
-	}
-	packet += getChar();
-	packet += getChar();
-	port->write("+");
-	if (!port->waitForBytesWritten(1000))
-		Util::panic();
+static Metrics::Histogram & get_time(Metrics::histogram("blackmagic.packet-get"));
+static Metrics::Counter & packets(Metrics::counter("blackmagic.packets-received"));
+static Metrics::Counter & bytes(Metrics::counter("blackmagic.bytes-received"));
+static Metrics::Histogram & request_reply_time(Metrics::histogram("blackmagic.request-reply"));
+Metrics::ScopedTimer timer(get_time);
+TRACE_SPAN_CATEGORY("Blackmagic::getPacket", "probe");
+QByteArray packet = link->getPacket();
+	/* the round trip time of a request - this includes the acknowledgement turnarounds, unless in no-ack mode */
+	if (request_timer.isValid())
+		request_reply_time.record(request_timer.nsecsElapsed() / 1000), request_timer.invalidate();
 	qDebug() << "received gdb packet:" << packet;
+	packets.increment();
+	bytes.increment(packet.length());
 	return packet;
 }
 
-char Blackmagic::getChar()
-{
-char c;
-	while (!port->bytesAvailable())
-		port->waitForReadyRead(10);
-	if (port->read(& c, 1) != 1)
-		Util::panic();
-	return c;
-}
-
-void Blackmagic::portReadyRead()
+void Blackmagic::stopReplyReceived(const QByteArray & packet)
 {
-auto halt_reason = getPacket();
-	qDebug() << "halt reason: " << halt_reason;
-	if (!disconnect(port, SIGNAL(readyRead()), 0, 0))
-		Util::panic();
-	if (GdbRemote::packetData(halt_reason) == "T05"
-		|| GdbRemote::packetData(halt_reason) == "T02")
-		emit targetHalted(GENERIC_HALT_CONDITION);
-	else
+static Metrics::Counter & expedited(Metrics::counter("blackmagic.expedited-registers"));
+	qDebug() << "halt reason: " << packet;
+	auto stop_reply = GdbRemote::parseStopReply(packet);
+	if (stop_reply.type != 'T' && stop_reply.type != 'S')
 		Util::panic();
+	halt_signal = stop_reply.signal;
+	/* the registers sent with the stop reply are used until all registers are read */
+	registers.clear();
+	expedited_registers = stop_reply.expedited_registers;
+	expedited.increment(expedited_registers.size());
+	emit targetHalted((stop_reply.reason == "hwbreak" || stop_reply.reason == "swbreak") ? BREAKPOINT_HIT : GENERIC_HALT_CONDITION);
 }
 
 bool Blackmagic::reset()
 {
 	registers.clear();
+	expedited_registers.clear();
 	putPacket(GdbRemote::resetRequest());
 	return true;
 }
 
 QByteArray Blackmagic::readBytes(uint32_t address, int byte_count, bool is_failure_allowed)
 {
-QVector<QByteArray> r;
-int i;
-	auto m = GdbRemote::readMemoryRequest(address, byte_count);
-	for (r.clear(), i = 0; i < m.size(); i ++)
+static Metrics::Counter & bytes_read(Metrics::counter("blackmagic.memory-bytes-read"));
+static Metrics::Gauge & throughput(Metrics::gauge("blackmagic.memory-read-bytes-per-second"));
+QByteArray data, reply, chunk;
+QElapsedTimer t;
+int length;
+	t.start();
+	while (data.size() < byte_count)
 	{
-		putPacket(m[i]);
-		r += getPacket();
-	}
-	for (i = 0; i < r.size(); i ++)
-		if (GdbRemote::isErrorResponse(r[i]))
+		length = Util::min(byte_count - data.size(), binary_read_mode != NO_BINARY_READS ? max_binary_read_size : max_hex_read_size);
+		if (binary_read_mode != NO_BINARY_READS)
+		{
+			putPacket(GdbRemote::binaryReadMemoryRequest(address + data.size(), length));
+			reply = getPacket();
+			chunk = GdbRemote::binaryReadMemoryData(reply, binary_read_mode == PREFIXED_BINARY_READS);
+		}
+		else
+		{
+			putPacket(GdbRemote::readMemoryRequest(address + data.size(), length));
+			reply = getPacket();
+			chunk = GdbRemote::readMemoryData(reply);
+		}
+		/* the reply may hold less data than requested - if so, continue reading after the data received */
+		if (GdbRemote::isErrorResponse(reply) || chunk.isEmpty() || chunk.size() > length)
+		{
 			if (!is_failure_allowed)
 			{
 				throw MEMORY_READ_ERROR;
 				Util::panic();
 			}
-			else
-				return QByteArray();
-	return GdbRemote::readMemory(r);
+			return QByteArray();
+		}
+		data += chunk;
+	}
+	bytes_read.increment(data.size());
+	/* small reads are dominated by the request turnaround, only update the throughput for larger reads */
+	if (data.size() >= 256)
+		throughput.set(data.size() * 1e9 / Util::max(t.nsecsElapsed(), (qint64) 1));
+	return data;
+}
+
+QVector<QByteArray> Blackmagic::readScatter(const QVector<struct memory_range> & ranges)
+{
+static Metrics::Counter & bytes_read(Metrics::counter("blackmagic.memory-bytes-read"));
+static Metrics::Histogram & scatter_read_time(Metrics::histogram("blackmagic.scatter-read"));
+static Metrics::Counter & round_trips(Metrics::counter("blackmagic.scatter-read-round-trips"));
+Metrics::ScopedTimer timer(scatter_read_time);
+TRACE_SPAN_CATEGORY("Blackmagic::readScatter", "probe");
+struct read_request
+{
+	int		range_index;
+	int		offset;
+	int		length;
+};
+QVector<QByteArray> data;
+QVector<bool> is_failed(ranges.size(), false);
+QVector<struct read_request> pending, requests;
+QByteArray reply, chunk;
+int i, length, max_read_size = binary_read_mode != NO_BINARY_READS ? max_binary_read_size : max_hex_read_size;
+
+	for (i = 0; i < ranges.size(); i ++)
+	{
+		data.push_back(QByteArray(Util::max(ranges.at(i).length, 0), 0));
+		for (length = 0; length < ranges.at(i).length; length += max_read_size)
+			pending.push_back((struct read_request) { .range_index = i, .offset = length, .length = Util::min(max_read_size, ranges.at(i).length - length), });
+	}
+	/* send a batch of requests before collecting any replies, so that a batch costs a single round trip
+	 * to the probe; the replies arrive in the order of the requests */
+	while (!pending.isEmpty())
+	{
+		requests = pending.mid(0, MAX_PIPELINED_READ_REQUESTS);
+		pending.remove(0, requests.size());
+		round_trips.increment();
+		for (i = 0; i < requests.size(); i ++)
+		{
+			const struct read_request & r(requests.at(i));
+			uint32_t address = ranges.at(r.range_index).address + r.offset;
+			putPacket(binary_read_mode != NO_BINARY_READS ? GdbRemote::binaryReadMemoryRequest(address, r.length) : GdbRemote::readMemoryRequest(address, r.length));
+		}
+		for (i = 0; i < requests.size(); i ++)
+		{
+			const struct read_request & r(requests.at(i));
+			reply = getPacket();
+			if (is_failed.at(r.range_index))
+				continue;
+			chunk = binary_read_mode != NO_BINARY_READS ? GdbRemote::binaryReadMemoryData(reply, binary_read_mode == PREFIXED_BINARY_READS) : GdbRemote::readMemoryData(reply);
+			if (GdbRemote::isErrorResponse(reply) || chunk.isEmpty() || chunk.size() > r.length)
+			{
+				is_failed[r.range_index] = true;
+				continue;
+			}
+			data[r.range_index].replace(r.offset, chunk.size(), chunk);
+			bytes_read.increment(chunk.size());
+			/* the reply may hold less data than requested - if so, read the rest with the next batch */
+			if (chunk.size() < r.length)
+				pending.push_back((struct read_request) { .range_index = r.range_index, .offset = r.offset + chunk.size(), .length = r.length - chunk.size(), });
+		}
+	}
+	for (i = 0; i < ranges.size(); i ++)
+		if (is_failed.at(i))
+			data[i].clear();
+	return data;
+}
+
+bool Blackmagic::writeBytes(uint32_t address, const QByteArray & data)
+{
+	putPacket(GdbRemote::writeMemoryRequest(address, data));
+	return GdbRemote::isOkResponse(getPacket());
+}
+
+bool Blackmagic::writeFlashBlocks(uint32_t address, const QByteArray & data)
+{
+static Metrics::Histogram & write_time(Metrics::histogram("blackmagic.flash-block-write"));
+Metrics::ScopedTimer timer(write_time);
+int i;
+	putPacket(GdbRemote::eraseFlashMemoryRequest(address, data.size()));
+	if (!GdbRemote::isOkResponse(getPacket()))
+		return false;
+	auto r = GdbRemote::writeFlashMemoryRequest(address, data.size(), data);
+	for (i = 0; i < r.size(); i ++)
+	{
+		putPacket(r[i]);
+		if (!GdbRemote::isOkResponse(getPacket()))
+			return false;
+	}
+	putPacket(GdbRemote::flashDoneRequest());
+	return GdbRemote::isOkResponse(getPacket());
 }
 
 uint32_t Blackmagic::readRawUncachedRegister(uint32_t register_number)
 {
+	if (registers.isEmpty() && expedited_registers.contains(register_number))
+		return expedited_registers.value(register_number);
 	if (register_number >= registers.size())
 		readAllRegisters();
 	if (register_number >= registers.size())
@@ -143,55 +262,77 @@ void Blackmagic::requestSingleStep(void)
 {
 	emit targetRunning();
 	registers.clear();
+	expedited_registers.clear();
+	halt_signal = 0;
+	link->expectStopReply();
 	putPacket(GdbRemote::singleStepRequest());
-	if (!QObject::connect(port, SIGNAL(readyRead()), this, SLOT(portReadyRead())))
-		Util::panic();
-	/*! \todo	WARNING - it seems that I am doing something wrong with the 'readyRead()' signal;
-	 *		without the call to 'waitForReadyRead()' below, on one machine that I am testing on,
-	 *		incoming data from the blackmagic probe sometimes does not cause the 'readyRead()'
-	 *		signal to be emitted, which breaks the code badly; I discovered through trial and
-	 *		error that the call to 'WaitForReadyRead()' function below seems to work around this issue
-	 * 		on some (but not all) machines that I tested on
-	 *
-	 * 		the same call is also currently present in the main troll front-end code, in file 'troll.cxx',
-	 * 		where waitForReadyRead() is being periodically called when the target is running - while the
-	 * 		call there is in my tests sufficient to work around the issue, the duplication here makes
-	 * 		the troll more responsive on some machines; tests concluded that just the call here (and without
-	 * 		periodically calling waitForReadyRead()) ***DOES NOT WORK*** in all occasions, so the redundant
-	 * 		call here is intended only to make the troll more responsive on some machines
-	 */
-	port->waitForReadyRead(1);
+}
+
+bool Blackmagic::requestRangeStep(uint32_t start_address, uint32_t end_address)
+{
+	if (!is_range_stepping_supported)
+		return false;
+	emit targetRunning();
+	registers.clear();
+	expedited_registers.clear();
+	halt_signal = 0;
+	link->expectStopReply();
+	putPacket(GdbRemote::rangeStepRequest(start_address, end_address));
+	return true;
 }
 
 bool Blackmagic::resume(void)
 {
 	emit targetRunning();
 	registers.clear();
+	expedited_registers.clear();
+	halt_signal = 0;
+	link->expectStopReply();
 	putPacket(GdbRemote::continueRequest());
-	if (!QObject::connect(port, SIGNAL(readyRead()), this, SLOT(portReadyRead())))
-		Util::panic();
-	/*! \todo	WARNING - it seems that I am doing something wrong with the 'readyRead()' signal;
-	 *		without the call to 'waitForReadyRead()' below, on one machine that I am testing on,
-	 *		incoming data from the blackmagic probe sometimes does not cause the 'readyRead()'
-	 *		signal to be emitted, which breaks the code badly; I discovered through trial and
-	 *		error that the call to 'WaitForReadyRead()' function below seems to work around this issue
-	 * 		on some (but not all) machines that I tested on
-	 *
-	 * 		the same call is also currently present in the main troll front-end code, in file 'troll.cxx',
-	 * 		where waitForReadyRead() is being periodically called when the target is running - while the
-	 * 		call there is in my tests sufficient to work around the issue, the duplication here makes
-	 * 		the troll more responsive on some machines; tests concluded that just the call here (and without
-	 * 		periodically calling waitForReadyRead()) ***DOES NOT WORK*** in all occasions, so the redundant
-	 * 		call here is intended only to make the troll more responsive on some machines
-	 */
-	port->waitForReadyRead(1);
 	return true;
 }
 
 bool Blackmagic::requestHalt()
 {
-	if (port->write("\003") == -1)
-		Util::panic();
+	link->write("\003");
+	return true;
+}
+
+bool Blackmagic::handshake(void)
+{
+	QByteArray reply;
+	bool is_acknowledged;
+
+	is_no_ack_mode = false;
+	link->setAckMode(true);
+	/* acknowledge anything pending, and drop any stale data */
+	link->write("+++");
+	while (!link->getPacket(250).isEmpty())
+		;
+	link->flush();
+
+	is_acknowledged = link->putPacket(GdbRemote::supportedFeaturesRequest(), HANDSHAKE_TIMEOUT_MS);
+	if ((reply = link->getPacket(HANDSHAKE_TIMEOUT_MS)).isEmpty())
+		return false;
+	if (!is_acknowledged)
+		/* a reply, but no acknowledgement - the gdb server is still in no-ack mode, left over from a previous session */
+		is_no_ack_mode = true;
+	else if (NO_ACK_MODE_ENABLED && GdbRemote::isFeatureSupported(reply, "QStartNoAckMode"))
+	{
+		/* the reply to this request is still acknowledged */
+		if (!link->putPacket(GdbRemote::startNoAckModeRequest(), HANDSHAKE_TIMEOUT_MS))
+			return false;
+		is_no_ack_mode = GdbRemote::isOkResponse(link->getPacket(HANDSHAKE_TIMEOUT_MS));
+	}
+	link->setAckMode(!is_no_ack_mode);
+	/* size the memory reads to fit the maximum packet size - both the request and the reply have a 4 byte
+	 * frame ('$', '#', and the two checksum digits), and binary replies may have an additional prefix byte */
+	int packet_size = GdbRemote::packetSize(reply);
+	max_hex_read_size = (packet_size > 0) ? Util::max((packet_size - 4) / 2, 1) : DEFAULT_MAX_HEX_READ_SIZE;
+	max_binary_read_size = (packet_size > 0) ? Util::max(packet_size - 5, 1) : DEFAULT_MAX_HEX_READ_SIZE;
+	Metrics::gauge("blackmagic.packet-size").set(packet_size);
+	Metrics::gauge("blackmagic.no-ack-mode").set(is_no_ack_mode ? 1 : 0);
+	qDebug() << "gdb remote no-ack mode" << (is_no_ack_mode ? "enabled" : "not enabled");
 	return true;
 }
 
@@ -201,16 +342,24 @@ bool Blackmagic::connect(void)
 	int i;
 	QVector<QByteArray> r, s;
 
-	if (!port->setDataTerminalReady(true))
-		Util::panic();
-	port->write("+++");
-	port->waitForBytesWritten(1000);
-	port->readAll();
-	qDebug() << "--------------> +++";
-	do
-		port->waitForReadyRead(1000);
-	while (port->readAll() > 0);
-	
+	port->close();
+	delete link;
+	link = new RspLink(port->portName());
+	QObject::connect(link, SIGNAL(stopReplyReceived(QByteArray)), this, SLOT(stopReplyReceived(QByteArray)));
+	/* if the handshake fails, reopen the port and retry once - this resets the gdb server
+	 * in the probe, in case it has been left in some weird state */
+	for (i = 0; i < 2; link->close(), i ++)
+		if (link->open() && handshake())
+			break;
+	if (i == 2)
+	{
+		/* not a blackmagic probe, or it does not respond - give the port back */
+		delete link;
+		link = 0;
+		port->open(QSerialPort::ReadWrite);
+		return false;
+	}
+
 	putPacket(packet);
 	do
 		r.push_back(getPacket());
@@ -225,8 +374,31 @@ bool Blackmagic::connect(void)
 		}
 	}
 	putPacket(GdbRemote::attachRequest());
-	if (GdbRemote::packetData(getPacket()) != "T05")
+	auto stop_reply = GdbRemote::parseStopReply(getPacket());
+	if (stop_reply.type != 'T' || stop_reply.signal != 5)
 		Util::panic();
+	halt_signal = stop_reply.signal;
+	registers.clear();
+	expedited_registers = stop_reply.expedited_registers;
+
+	/* probe for binary memory read support with an empty read - an empty reply means that binary reads are not supported;
+	 * gdb servers that follow the gdb documentation reply with a lone 'b', while lldb-style servers reply with 'OK' */
+	binary_read_mode = NO_BINARY_READS;
+	if (BINARY_READS_ENABLED)
+	{
+		putPacket(GdbRemote::binaryReadMemoryRequest(0, 0));
+		auto reply = GdbRemote::packetData(getPacket());
+		if (reply == "b")
+			binary_read_mode = PREFIXED_BINARY_READS;
+		else if (reply == "OK")
+			binary_read_mode = BINARY_READS;
+	}
+	Metrics::gauge("blackmagic.binary-memory-reads").set(binary_read_mode != NO_BINARY_READS ? 1 : 0);
+
+	putPacket(GdbRemote::vContQueryRequest());
+	is_range_stepping_supported = GdbRemote::isVContActionSupported(getPacket(), "r");
+	qDebug() << "range stepping" << (is_range_stepping_supported ? "supported" : "not supported");
+	qDebug() << "binary memory reads" << (binary_read_mode != NO_BINARY_READS ? "enabled" : "not enabled");
 	return true;
 }
 
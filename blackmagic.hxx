@@ -24,34 +24,71 @@ THE SOFTWARE.
 
 #include <QSerialPort>
 #include <QVector>
+#include <QMap>
+#include <QElapsedTimer>
 
 #include "target.hxx"
+#include "rsp-link.hxx"
 
 class Blackmagic : public Target
 {
 Q_OBJECT
 private:
 	QVector<uint32_t>	registers;
+	/* the registers sent inline with the last stop reply, keyed by register number; these are used
+	 * while 'registers' is empty, so that the registers most often needed after a halt (e.g. the
+	 * program counter) are available without a separate register read request */
+	QMap<int, uint32_t>	expedited_registers;
+	/* the signal number reported in the last stop reply, zero while the target is running */
+	int		halt_signal;
+	/* the serial port of the probe, as opened by the front end; it is closed while the probe is
+	 * accessed through 'link', which opens the port again in its own input/output thread */
 	QSerialPort	* port;
+	RspLink		* link;
+	/* true, if the gdb server in the probe has accepted the 'QStartNoAckMode' request, in which case
+	 * packets are no longer acknowledged in either direction */
+	bool		is_no_ack_mode;
+	/* the maximum number of bytes to read with a single memory read request, sized for the maximum packet size
+	 * of the probe */
+	int		max_hex_read_size, max_binary_read_size;
+	enum
+	{
+		/* binary memory reads are not supported, use hex encoded reads */
+		NO_BINARY_READS,
+		/* binary memory reads are supported, the data in the replies is not prefixed */
+		BINARY_READS,
+		/* binary memory reads are supported, the data in the replies is prefixed with a 'b' character */
+		PREFIXED_BINARY_READS,
+	}
+	binary_read_mode;
+	/* true, if the gdb server in the probe supports the 'vCont;r' (range stepping) action */
+	bool		is_range_stepping_supported;
+	/* measures the time from sending a request to receiving the reply */
+	QElapsedTimer	request_timer;
 	void readAllRegisters(void);
 	void putPacket(const QByteArray & request);
 	QByteArray getPacket(void);
-	char getChar(void);
+	bool handshake(void);
 private slots:
-	void portReadyRead(void);
+	void stopReplyReceived(const QByteArray & packet);
 public:
-	Blackmagic(QSerialPort * port) { this->port = port; }
+	Blackmagic(QSerialPort * port) { this->port = port; link = 0; halt_signal = 0; is_no_ack_mode = false; is_range_stepping_supported = false; max_hex_read_size = max_binary_read_size = 1000; binary_read_mode = NO_BINARY_READS; }
+	~Blackmagic() { delete link; }
 	uint32_t readWord(uint32_t address) { auto x = readBytes(address, sizeof(uint32_t)); if (x.size() != sizeof(uint32_t)) Util::panic(); return * (uint32_t *) x.constData(); }
 	bool reset(void);
 	QByteArray readBytes(uint32_t address, int byte_count, bool is_failure_allowed = false);
+	QVector<QByteArray> readScatter(const QVector<struct memory_range> & ranges);
+	bool writeBytes(uint32_t address, const QByteArray & data);
+	bool writeFlashBlocks(uint32_t address, const QByteArray & data);
 	uint32_t readRawUncachedRegister(uint32_t register_number);
 	bool breakpointSet(uint32_t address, int length);
 	bool breakpointClear(uint32_t address, int length);
 	void requestSingleStep(void);
+	bool requestRangeStep(uint32_t start_address, uint32_t end_address);
 	bool resume(void);
 	bool requestHalt(void);
 	bool connect(void);
-	uint32_t haltReason(void){ Util::panic(); }
+	uint32_t haltReason(void) { return halt_signal; }
 	QByteArray memoryMap(void);
 	bool syncFlash(const Memory & memory_contents);
 };
@@ -21,9 +21,12 @@ THE SOFTWARE.
 */
 #include <QDebug>
 #include <QTime>
+#include <QElapsedTimer>
 #include <QMessageBox>
 #include "blackstrike.hxx"
 #include "memory.hxx"
+#include "metrics.hxx"
+#include "trace.hxx"
 
 #define BLACKSTIRKE_DEBUG	0
 
@@ -84,6 +87,10 @@ QByteArray Blackstrike::interrogate(const QByteArray & query, bool *isOk)
 	if (query.indexOf(".( <<<start>>>)") >= query.indexOf(".( <<<end>>>)"))
 		Util::panic();
 
+static Metrics::Histogram & query_time(Metrics::histogram("blackstrike.query"));
+static Metrics::Counter & timeouts(Metrics::counter("blackstrike.query-timeouts"));
+Metrics::ScopedTimer timer(query_time);
+TRACE_SPAN_CATEGORY("Blackstrike::interrogate", "probe");
 QByteArray s;
 QRegExp rx("<<<start>>>(.*)<<<end>>>");
 int l, r;
@@ -102,6 +109,7 @@ QTime t;
 		{
 			if (isOk)
 				* isOk = false;
+			timeouts.increment();
 			return "query timed out";
 		}
 	}
@@ -128,17 +136,49 @@ bool Blackstrike::reset(void)
 
 QByteArray Blackstrike::readBytes(uint32_t address, int byte_count, bool is_failure_allowed)
 {
-QTime t;
+static Metrics::Histogram & read_time(Metrics::histogram("blackstrike.memory-read"));
+static Metrics::Counter & bytes_read(Metrics::counter("blackstrike.memory-bytes-read"));
+static Metrics::Gauge & throughput(Metrics::gauge("blackstrike.memory-read-throughput-bytes-per-second"));
+QElapsedTimer t;
 QString s(
 " $%1 $%2 "
 " .( <<<start>>>) target-dump .( <<<end>>>) cr "
 );
 	t.start();
 	auto x = interrogate(s.arg(address, 0, 16).arg(byte_count, 0, 16).toLocal8Bit());
-	qDebug() << "usb xfer speed:" << ((float) x.length() / t.elapsed()) * 1000. << "bytes/second";
+	qint64 microseconds = t.nsecsElapsed() / 1000;
+	read_time.record(microseconds);
+	bytes_read.increment(x.length());
+	if (microseconds)
+		throughput.set(x.length() * 1000000. / microseconds);
 	return x;
 }
 
+QVector<QByteArray> Blackstrike::readScatter(const QVector<struct memory_range> & ranges)
+{
+static Metrics::Histogram & read_time(Metrics::histogram("blackstrike.memory-scatter-read"));
+static Metrics::Counter & bytes_read(Metrics::counter("blackstrike.memory-bytes-read"));
+Metrics::ScopedTimer timer(read_time);
+QVector<QByteArray> data;
+QString s(" .( <<<start>>>) ");
+int i, offset, length = 0;
+bool ok;
+
+	/* dump all of the ranges with a single query; the dumps are contiguous in the reply, and are split
+	 * by the lengths of the ranges */
+	for (i = 0; i < ranges.size(); length += ranges.at(i ++).length)
+		s += QString(" $%1 $%2 target-dump ").arg(ranges.at(i).address, 0, 16).arg(ranges.at(i).length, 0, 16);
+	s += " .( <<<end>>>) cr ";
+	auto x = interrogate(s.toLocal8Bit(), & ok);
+	if (!ok || x.length() != length)
+		/* some range could not be read - fall back to reading the ranges one by one */
+		return Target::readScatter(ranges);
+	bytes_read.increment(x.length());
+	for (offset = i = 0; i < ranges.size(); offset += ranges.at(i ++).length)
+		data.push_back(x.mid(offset, ranges.at(i).length));
+	return data;
+}
+
 uint32_t Blackstrike::readWord(uint32_t address)
 {
 QString s;
@@ -41,6 +41,7 @@ public:
 	bool reset(void);
 	Blackstrike(QSerialPort * port) { this->port = port; }
 	QByteArray readBytes(uint32_t address, int byte_count, bool is_failure_allowed = false);
+	QVector<QByteArray> readScatter(const QVector<struct memory_range> & ranges);
 	uint32_t readWord(uint32_t address);
 	uint32_t readRawUncachedRegister(uint32_t register_number);
 	bool breakpointSet(uint32_t address, int length);
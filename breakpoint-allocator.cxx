@@ -0,0 +1,301 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#include "breakpoint-allocator.hxx"
+#include "metrics.hxx"
+
+/* the size of the code patched for software and flash patch breakpoints */
+#define BKPT_INSTRUCTION_SIZE		2
+
+/* the thumb 'bkpt #0' instruction, in target byte order */
+static const QByteArray bkpt_instruction("\x00\xbe", BKPT_INSTRUCTION_SIZE);
+
+int BreakpointAllocator::hardwareBreakpointCount(void)
+{
+	return count(HARDWARE_BREAKPOINT);
+}
+
+int BreakpointAllocator::count(enum BREAKPOINT_KIND kind)
+{
+	int n = 0;
+	for (auto x = installed.constBegin(); x != installed.constEnd(); x ++)
+		if (x.value().kind == kind)
+			n ++;
+	return n;
+}
+
+bool BreakpointAllocator::installSoftwareBreakpoint(uint32_t address)
+{
+static Metrics::Counter & breakpoints_set(Metrics::counter("breakpoints.software-breakpoints-set"));
+struct Breakpoint b;
+	b.kind = SOFTWARE_BREAKPOINT;
+	b.original_code = target->readBytes(address, BKPT_INSTRUCTION_SIZE, true);
+	if (b.original_code.size() != BKPT_INSTRUCTION_SIZE || !target->writeBytes(address, bkpt_instruction))
+		return false;
+	installed.insert(address, b);
+	breakpoints_set.increment();
+	return true;
+}
+
+bool BreakpointAllocator::installHardwareBreakpoint(uint32_t address)
+{
+static Metrics::Counter & breakpoints_set(Metrics::counter("breakpoints.hardware-breakpoints-set"));
+struct Breakpoint b;
+	/* do not waste a round trip if all comparators are known to be in use */
+	if (hardware_breakpoint_limit != -1 && hardwareBreakpointCount() >= hardware_breakpoint_limit)
+		return false;
+	/* a failure does not necessarily mean that all comparators are in use - see 'replaceHardwareBreakpoint()' */
+	if (!target->breakpointSet(address, BKPT_INSTRUCTION_SIZE))
+		return false;
+	b.kind = HARDWARE_BREAKPOINT;
+	installed.insert(address, b);
+	breakpoints_set.increment();
+	return true;
+}
+
+bool BreakpointAllocator::replaceHardwareBreakpoint(uint32_t victim, uint32_t address)
+{
+	remove(victim);
+	if (installHardwareBreakpoint(address))
+	{
+		if (hardware_breakpoint_limit == -1)
+			/* the breakpoint could not be installed only because all comparators were in use */
+			hardware_breakpoint_limit = hardwareBreakpointCount();
+		return true;
+	}
+	installHardwareBreakpoint(victim);
+	return false;
+}
+
+void BreakpointAllocator::remove(uint32_t address)
+{
+static Metrics::Counter & breakpoints_cleared(Metrics::counter("breakpoints.hardware-breakpoints-cleared"));
+	const struct Breakpoint & b(installed[address]);
+	switch (b.kind)
+	{
+		case HARDWARE_BREAKPOINT:
+			target->breakpointClear(address, BKPT_INSTRUCTION_SIZE);
+			breakpoints_cleared.increment();
+			break;
+		case SOFTWARE_BREAKPOINT:
+			target->writeBytes(address, b.original_code);
+			break;
+		default:
+			/* flash patch breakpoints are removed by rewriting the flash block that holds them */
+			Util::panic();
+	}
+	installed.remove(address);
+}
+
+bool BreakpointAllocator::rewriteFlashBlock(uint32_t block_address, uint32_t block_size, const QMap<uint32_t, QByteArray> & removed_code)
+{
+static Metrics::Counter & blocks_patched(Metrics::counter("breakpoints.flash-blocks-patched"));
+	QByteArray data = target->readBytes(block_address, block_size, true);
+	if (data.size() != block_size)
+		return false;
+	/* restore the original code of all breakpoints patched in the block - the data read may not hold it, unless it comes
+	 * from the verified executable image */
+	for (auto x = removed_code.constBegin(); x != removed_code.constEnd(); x ++)
+		if (x.key() - block_address < block_size)
+			data.replace(x.key() - block_address, BKPT_INSTRUCTION_SIZE, x.value());
+	for (auto x = installed.constBegin(); x != installed.constEnd(); x ++)
+		if (x.value().kind == FLASH_PATCH_BREAKPOINT && x.key() - block_address < block_size && !x.value().original_code.isEmpty())
+			data.replace(x.key() - block_address, BKPT_INSTRUCTION_SIZE, x.value().original_code);
+	for (auto x = installed.begin(); x != installed.end(); x ++)
+		if (x.value().kind == FLASH_PATCH_BREAKPOINT && x.key() - block_address < block_size)
+		{
+			x.value().original_code = data.mid(x.key() - block_address, BKPT_INSTRUCTION_SIZE);
+			data.replace(x.key() - block_address, BKPT_INSTRUCTION_SIZE, bkpt_instruction);
+		}
+	blocks_patched.increment();
+	return target->writeFlashBlocks(block_address, data);
+}
+
+QVector<uint32_t> BreakpointAllocator::sync(const QVector<uint32_t> & breakpoints_by_priority)
+{
+static Metrics::Counter & evictions(Metrics::counter("breakpoints.hardware-breakpoint-evictions"));
+QVector<uint32_t> unresolved, spilled;
+QMap<uint32_t /* address */, int /* priority */> priorities;
+QMap<uint32_t /* block address */, uint32_t /* block size */> flash_blocks;
+QMap<uint32_t /* address */, QByteArray> removed_code;
+int i;
+	if (!target)
+		return breakpoints_by_priority;
+	/* for duplicate addresses, the highest priority (i.e. the lowest index) is used */
+	for (i = breakpoints_by_priority.size() - 1; i >= 0; i --)
+		priorities.insert(breakpoints_by_priority.at(i), i);
+
+	/* remove the breakpoints no longer requested */
+	foreach (uint32_t address, installed.keys())
+		if (!priorities.contains(address))
+		{
+			if (installed[address].kind != FLASH_PATCH_BREAKPOINT)
+				remove(address);
+			else
+			{
+				auto block = target->flashBlockForAddress(address);
+				flash_blocks.insert(block.first, block.second);
+				removed_code.insert(address, installed[address].original_code);
+				installed.remove(address);
+			}
+		}
+
+	for (i = 0; i < breakpoints_by_priority.size(); i ++)
+	{
+		uint32_t address = breakpoints_by_priority.at(i), victim = 0;
+		int victim_priority = -1;
+		if (installed.contains(address) || priorities.value(address) != i)
+			continue;
+		if (target->isRamAddress(address) && installSoftwareBreakpoint(address))
+			continue;
+		if (installHardwareBreakpoint(address))
+			continue;
+		for (auto x = installed.constBegin(); x != installed.constEnd(); x ++)
+			if (x.value().kind == HARDWARE_BREAKPOINT && priorities.value(x.key()) > victim_priority)
+				victim = x.key(), victim_priority = priorities.value(x.key());
+		if (victim_priority == -1 || (hardware_breakpoint_limit != -1 && hardwareBreakpointCount() < hardware_breakpoint_limit))
+		{
+			/* no comparators are in use, or there are free comparators - the failure is not caused by running out of
+			 * comparators, so only this breakpoint is affected */
+			unresolved.push_back(address);
+			continue;
+		}
+		if (victim_priority < i && hardware_breakpoint_limit != -1)
+		{
+			/* all comparators are in use by higher priority breakpoints */
+			spilled.push_back(address);
+			continue;
+		}
+		/* evict the lowest priority hardware breakpoint; if the number of comparators is not yet known, this is also
+		 * done to find out if the failure is caused by running out of comparators */
+		if (!replaceHardwareBreakpoint(victim, address))
+		{
+			unresolved.push_back(address);
+			if (!installed.contains(victim))
+				spilled.push_back(victim);
+			continue;
+		}
+		if (victim_priority > i)
+		{
+			spilled.push_back(victim);
+			evictions.increment();
+		}
+		/* the breakpoint evicted has a higher priority - it was only evicted to learn the number of comparators, give the comparator back */
+		else if (!replaceHardwareBreakpoint(address, victim))
+		{
+			spilled.push_back(victim);
+			if (!installed.contains(address))
+				spilled.push_back(address);
+		}
+		else
+			spilled.push_back(address);
+	}
+
+	/* install the breakpoints that did not get a hardware comparator by patching flash */
+	for (i = 0; i < spilled.size(); i ++)
+	{
+		auto block = target->flashBlockForAddress(spilled.at(i));
+		if (!is_flash_patching_enabled || !block.second)
+		{
+			unresolved.push_back(spilled.at(i));
+			continue;
+		}
+		struct Breakpoint b;
+		b.kind = FLASH_PATCH_BREAKPOINT;
+		installed.insert(spilled.at(i), b);
+		flash_blocks.insert(block.first, block.second);
+	}
+	for (auto block = flash_blocks.constBegin(); block != flash_blocks.constEnd(); block ++)
+		if (!rewriteFlashBlock(block.key(), block.value(), removed_code))
+		{
+			/* the contents of the flash block are now unknown - consider all breakpoints in it lost */
+			foreach (uint32_t address, installed.keys())
+				if (installed[address].kind == FLASH_PATCH_BREAKPOINT && address - block.key() < block.value())
+					installed.remove(address), unresolved.push_back(address);
+		}
+	return unresolved;
+}
+
+bool BreakpointAllocator::installTemporaryBreakpoints(const QVector<uint32_t> & addresses)
+{
+static Metrics::Counter & refused(Metrics::counter("breakpoints.temporary-breakpoint-sets-refused"));
+QVector<uint32_t> installed_now;
+QSet<uint32_t> needed;
+int i, j;
+	if (!target)
+		return false;
+	/* do not waste round trips if the breakpoints are known not to fit in the free comparators */
+	for (i = 0; i < addresses.size(); i ++)
+		if (!installed.contains(addresses.at(i)) && !target->isRamAddress(addresses.at(i)))
+			needed.insert(addresses.at(i));
+	if (hardware_breakpoint_limit != -1 && hardwareBreakpointCount() + needed.size() > hardware_breakpoint_limit)
+	{
+		refused.increment();
+		return false;
+	}
+	for (i = 0; i < addresses.size(); i ++)
+	{
+		uint32_t address = addresses.at(i);
+		if (installed.contains(address))
+			continue;
+		if ((target->isRamAddress(address) && installSoftwareBreakpoint(address)) || installHardwareBreakpoint(address))
+		{
+			installed_now.push_back(address);
+			continue;
+		}
+		if (hardware_breakpoint_limit == -1)
+		{
+			/* learn the number of comparators, if possible, by trying the failed breakpoint in place of a hardware
+			 * breakpoint installed here, so that the next time the breakpoints are known not to fit */
+			for (j = installed_now.size() - 1; j >= 0 && installed[installed_now.at(j)].kind != HARDWARE_BREAKPOINT; j --)
+				;
+			if (j >= 0 && replaceHardwareBreakpoint(installed_now.at(j), address))
+				installed_now.replace(j, address);
+		}
+		break;
+	}
+	if (i == addresses.size())
+		return true;
+	for (i = 0; i < installed_now.size(); i ++)
+		if (installed.contains(installed_now.at(i)))
+			remove(installed_now.at(i));
+	refused.increment();
+	return false;
+}
+
+bool BreakpointAllocator::removeFlashPatchBreakpoints(void)
+{
+QMap<uint32_t /* block address */, uint32_t /* block size */> flash_blocks;
+QMap<uint32_t /* address */, QByteArray> removed_code;
+bool result = true;
+	foreach (uint32_t address, installed.keys())
+		if (installed[address].kind == FLASH_PATCH_BREAKPOINT)
+		{
+			auto block = target->flashBlockForAddress(address);
+			flash_blocks.insert(block.first, block.second);
+			removed_code.insert(address, installed[address].original_code);
+			installed.remove(address);
+		}
+	for (auto block = flash_blocks.constBegin(); block != flash_blocks.constEnd(); block ++)
+		if (!rewriteFlashBlock(block.key(), block.value(), removed_code))
+			result = false;
+	return result;
+}
@@ -0,0 +1,95 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef BREAKPOINTALLOCATOR_HXX
+#define BREAKPOINTALLOCATOR_HXX
+
+#include <stdint.h>
+#include <QMap>
+#include <QSet>
+#include <QVector>
+#include <QByteArray>
+#include "target.hxx"
+
+/* allocates target resources for the breakpoints requested, and installs them in the target
+ *
+ * breakpoints in ram are installed by patching the code with 'bkpt' instructions; all other breakpoints are installed in
+ * the hardware breakpoint comparators of the target, with higher priority breakpoints taking precedence - if there are no
+ * free comparators for a breakpoint, the lowest priority breakpoint holding a comparator is evicted, if it has a lower
+ * priority; breakpoints that do not get a comparator are not installed, unless flash patching is enabled - then they
+ * are installed by patching the code in flash, which is slow, and wears the flash, so it is disabled by default;
+ * breakpoints stay installed until they are no longer requested, or until a new target is set; flash patch breakpoints
+ * must be removed (see 'removeFlashPatchBreakpoints()') before disconnecting from the target, or else they are left in
+ * the target flash, and the target will halt on them when running without a debugger */
+class BreakpointAllocator
+{
+public:
+	enum BREAKPOINT_KIND
+	{
+		HARDWARE_BREAKPOINT,
+		SOFTWARE_BREAKPOINT,
+		FLASH_PATCH_BREAKPOINT,
+	};
+private:
+	struct Breakpoint
+	{
+		enum BREAKPOINT_KIND	kind;
+		/* for software and flash patch breakpoints, the original contents of the patched code */
+		QByteArray	original_code;
+	};
+	Target	* target;
+	QMap<uint32_t /* address */, struct Breakpoint> installed;
+	/* the number of hardware comparators, or -1 if not yet known; this is only learned when a hardware breakpoint, that
+	 * failed to install, is successfully installed in place of another hardware breakpoint */
+	int	hardware_breakpoint_limit;
+	bool	is_flash_patching_enabled;
+	int hardwareBreakpointCount(void);
+	bool installSoftwareBreakpoint(uint32_t address);
+	bool installHardwareBreakpoint(uint32_t address);
+	void remove(uint32_t address);
+	/* removes the hardware breakpoint at 'victim', and installs a hardware breakpoint at 'address' in its place; if that
+	 * fails, the breakpoint at 'victim' is reinstalled, and false is returned */
+	bool replaceHardwareBreakpoint(uint32_t victim, uint32_t address);
+	/* reprograms a flash block, with all flash patch breakpoints in the block installed, and the original code of the
+	 * removed breakpoints passed restored; returns false on error */
+	bool rewriteFlashBlock(uint32_t block_address, uint32_t block_size, const QMap<uint32_t, QByteArray> & removed_code);
+public:
+	BreakpointAllocator(void) { target = 0; hardware_breakpoint_limit = -1; is_flash_patching_enabled = false; }
+	/* the breakpoints installed in the previous target are considered lost */
+	void setTarget(Target * target) { this->target = target; installed.clear(); hardware_breakpoint_limit = -1; }
+	/* installs the breakpoints passed, and removes all other breakpoints; breakpoints earlier in the vector have a higher
+	 * priority; returns the addresses of the breakpoints that could not be installed */
+	QVector<uint32_t> sync(const QVector<uint32_t> & breakpoints_by_priority);
+	/* installs short lived breakpoints (e.g. for stepping), in addition to the ones installed by 'sync()'; only ram patching
+	 * and free comparators are used - installed breakpoints are never evicted, and flash is never patched; if not all of the
+	 * breakpoints can be installed, none of them is installed, and false is returned; the breakpoints installed are removed
+	 * by the next call to 'sync()' */
+	bool installTemporaryBreakpoints(const QVector<uint32_t> & addresses);
+	bool isInstalled(uint32_t address) { return installed.contains(address); }
+	bool isFlashPatched(uint32_t address) { auto x = installed.constFind(address); return x != installed.constEnd() && x.value().kind == FLASH_PATCH_BREAKPOINT; }
+	/* flash patching is an explicit opt-in; disabling it does not remove the flash patch breakpoints already installed */
+	void setFlashPatchingEnabled(bool is_enabled) { is_flash_patching_enabled = is_enabled; }
+	/* restores the original code of all flash patch breakpoints; the target must be halted; returns false on error */
+	bool removeFlashPatchBreakpoints(void);
+	int count(enum BREAKPOINT_KIND kind);
+};
+
+#endif // BREAKPOINTALLOCATOR_HXX
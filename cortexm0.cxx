@@ -27,15 +27,31 @@ THE SOFTWARE.
 static Target		* target;
 static Sforth		* sforth;
 static RegisterCache	* register_cache;
+/* a copy of the target stack memory, starting at the stack pointer, read when priming the unwinder; most of
+ * the memory fetches done while unwinding the stack and evaluating the locations of local data objects are
+ * from this area, and are served from here instead of issuing a target memory read for each fetch */
+static QByteArray	stack_window;
+static uint32_t		stack_window_address;
+
+/* the size of the stack window, and the size of the ranges it is read in - reading stops at the first range
+ * that cannot be read, e.g. when the stack is near the end of ram */
+#define STACK_WINDOW_SIZE	1024
+#define STACK_WINDOW_READ_SIZE	256
 
 extern "C"
 {
 void do_target_fetch(void)
 {
 	auto x = sforth->getResults(1); if (x.size() != 1) Util::panic();
+	uint32_t address = x.at(0);
+	if (stack_window_address <= address && address - stack_window_address + sizeof(uint32_t) <= stack_window.size())
+	{
+		sforth->push(* (uint32_t *) (stack_window.constData() + address - stack_window_address));
+		return;
+	}
 	try
 	{
-		sforth->push(target->readWord(x.at(0)));
+		sforth->push(target->readWord(address));
 	}
 	catch (enum TARGET_ERROR_ENUM error)
 	{
@@ -61,6 +77,7 @@ void CortexM0::readRawRegistersFromTarget()
 {
 	int i;
 	registers.clear();
+	are_all_registers_read = true;
 	sforth->evaluate("unwound-registers\n");
 	auto r = sforth->getResults(1);
 	if (r.size() != 1)
@@ -73,6 +90,7 @@ CortexM0::CortexM0(Sforth * sforth_engine, Target *target_controller, RegisterCa
 	sforth = sforth_engine;
 	target = target_controller;
 	register_cache = registers;
+	are_all_registers_read = true;
 	QFile f(":/sforth/unwinder.fs");
 	f.open(QFile::ReadOnly);
 	sforth->push(register_count);
@@ -82,19 +100,51 @@ CortexM0::CortexM0(Sforth * sforth_engine, Target *target_controller, RegisterCa
 void CortexM0::setTargetController(Target *target_controller)
 {
 	target = target_controller;
+	invalidateStackWindow();
+}
+
+void CortexM0::invalidateStackWindow(void)
+{
+	stack_window.clear();
 }
 
 void CortexM0::primeUnwinder()
 {
 int i;
-	registers.clear();
-	for (i = 0; i < register_count; registers.push_back(target->readRawUncachedRegister(i++)));
+QVector<struct Target::memory_range> ranges;
+	/* the target usually sends the program counter, stack pointer and return address registers when it halts - read
+	 * only these here, so that reading them needs no round trip to the target; reading any other register may read
+	 * all registers from the target, so these are only read when needed */
+	registers.assign(register_count, 0);
+	registers.at(program_counter_register_number) = target->readRawUncachedRegister(program_counter_register_number);
+	registers.at(stack_pointer_register_number) = target->readRawUncachedRegister(stack_pointer_register_number);
+	registers.at(return_address_register_number) = target->readRawUncachedRegister(return_address_register_number);
+	are_all_registers_read = false;
+	/* read the stack window with a single scattered read */
+	stack_window.clear();
+	stack_window_address = registers.at(stack_pointer_register_number);
+	for (i = 0; i < STACK_WINDOW_SIZE; i += STACK_WINDOW_READ_SIZE)
+		ranges.push_back((struct Target::memory_range) { .address = stack_window_address + i, .length = STACK_WINDOW_READ_SIZE, });
+	auto data = target->readScatter(ranges);
+	for (i = 0; i < data.size() && data.at(i).size() == STACK_WINDOW_READ_SIZE; stack_window += data.at(i ++));
+}
+
+void CortexM0::readRemainingRegisters(void)
+{
+int i;
+	if (are_all_registers_read)
+		return;
+	for (i = 0; i < register_count; i ++)
+		if (i != program_counter_register_number && i != stack_pointer_register_number && i != return_address_register_number)
+			registers.at(i) = target->readRawUncachedRegister(i);
+	are_all_registers_read = true;
 }
 
 bool CortexM0::unwindFrame(const QString & unwind_code, uint32_t start_address, uint32_t unwind_address)
 {
 int i;
 uint32_t cfa;
+	readRemainingRegisters();
 	for (i = 0; i < registers.size(); sforth->push(registers.at(i++)));
 	sforth->evaluate("init-unwinder-round\n");
 	sforth->evaluate(QString("%1 to current-address %2 to unwind-address ").arg(start_address).arg(unwind_address) + unwind_code + '\n');
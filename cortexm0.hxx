@@ -34,13 +34,19 @@ private:
 		return_address_register_number,
 		cfa_register_number;
 	std::vector<uint32_t> registers;
+	/* false if only the program counter, stack pointer and return address registers in 'registers' have been read
+	 * from the target - the other registers are only read by 'readRemainingRegisters()', when they are needed */
+	bool are_all_registers_read;
+	void readRemainingRegisters(void);
 	void readRawRegistersFromTarget(void);
 public:
 	CortexM0(Sforth * sforth_engine, class Target * target_controller, RegisterCache *registers);
 	void setTargetController(class Target * target_controller);
 	void primeUnwinder(void);
+	/* must be called when the target memory may have changed, e.g. when the target is resumed */
+	void invalidateStackWindow(void);
 	bool unwindFrame(const QString & unwind_code, uint32_t start_address, uint32_t unwind_address);
-	std::vector<uint32_t> getRegisters(void) { return registers; }
+	std::vector<uint32_t> getRegisters(void) { readRemainingRegisters(); return registers; }
 	uint32_t programCounter(void) { if (registers.size() <= program_counter_register_number) Util::panic(); return registers.at(program_counter_register_number)&~1; }
 	uint32_t stackPointerValue(void) { if (registers.size() <= stack_pointer_register_number) Util::panic(); return registers.at(stack_pointer_register_number); }
 	bool architecturalUnwind(void);
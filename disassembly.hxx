@@ -206,6 +206,77 @@ public:
 		}
 		return dis;
 	}
+	/* analyzes the machine code in an address range, for stepping over the range at full speed with breakpoints:
+	 * computes the addresses at which execution may leave the range - the end of the range, and the targets
+	 * of direct branches (including calls) out of the range - and the addresses of the indirect branch instructions
+	 * in the range, whose targets are not known until they are executed; returns false if the code in the range
+	 * cannot be read or disassembled */
+	bool rangeExits(uint32_t start, uint32_t end, class Target * target, QVector<uint32_t> & exits, QVector<uint32_t> & indirect_branches)
+	{
+		cs_insn	* insn;
+		size_t	count, i;
+		int	j;
+		bool	is_ok = true;
+		exits.clear();
+		indirect_branches.clear();
+		if (end <= start)
+			return false;
+		auto code = target->readBytes(start, end - start, true);
+		if (code.size() != end - start)
+			return false;
+		exits.push_back(end);
+		cs_option(cs_handle, CS_OPT_DETAIL, CS_OPT_ON);
+		count = cs_disasm(cs_handle, (const uint8_t *) code.constData(), code.size(), start, 0, & insn);
+		if (!count || insn[count - 1].address + insn[count - 1].size != end)
+			/* some bytes could not be disassembled */
+			is_ok = false;
+		for (i = 0; is_ok && i < count; i ++)
+		{
+			const cs_arm & arm(insn[i].detail->arm);
+			bool is_indirect = false;
+			switch (insn[i].id)
+			{
+				case ARM_INS_B:
+				case ARM_INS_BL:
+				case ARM_INS_CBZ:
+				case ARM_INS_CBNZ:
+					for (j = 0; j < arm.op_count; j ++)
+						if (arm.operands[j].type == ARM_OP_IMM)
+						{
+							uint32_t target_address = arm.operands[j].imm;
+							if ((target_address < start || end <= target_address) && !exits.contains(target_address))
+								exits.push_back(target_address);
+						}
+					break;
+				case ARM_INS_BX:
+				case ARM_INS_BLX:
+				case ARM_INS_TBB:
+				case ARM_INS_TBH:
+					is_indirect = true;
+					break;
+				case ARM_INS_POP:
+				case ARM_INS_LDM:
+					/* the program counter is in the register list */
+					for (j = 0; j < arm.op_count; j ++)
+						if (arm.operands[j].type == ARM_OP_REG && arm.operands[j].reg == ARM_REG_PC)
+							is_indirect = true;
+					break;
+				case ARM_INS_LDR:
+				case ARM_INS_MOV:
+				case ARM_INS_ADD:
+					/* the program counter is the destination */
+					if (arm.op_count && arm.operands[0].type == ARM_OP_REG && arm.operands[0].reg == ARM_REG_PC)
+						is_indirect = true;
+					break;
+			}
+			if (is_indirect)
+				indirect_branches.push_back(insn[i].address);
+		}
+		if (count)
+			cs_free(insn, count);
+		cs_option(cs_handle, CS_OPT_DETAIL, CS_OPT_OFF);
+		return is_ok;
+	}
 	void disassemble(const uint8_t * bytes, int length, uint32_t address)
 	{
 		csh handle;
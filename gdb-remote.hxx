@@ -22,9 +22,11 @@ THE SOFTWARE.
 #ifndef GDBREMOTE_HXX
 #define GDBREMOTE_HXX
 
+#include <string.h>
 #include <QByteArray>
 #include <QString>
 #include <QVector>
+#include <QMap>
 #include <QDebug>
 #include "util.hxx"
 
@@ -63,8 +65,18 @@ public:
 	static QByteArray monitorRequest(const QString & request) { return makePacket((QByteArray("qRcmd,") + request.toLocal8Bit().toHex())); }
 	static QByteArray readRegistersRequest(void) { return makePacket("g"); }
 	static QByteArray attachRequest(void) { return makePacket("vAttach;1"); }
+	static QByteArray supportedFeaturesRequest(void) { return makePacket("qSupported"); }
+	static QByteArray startNoAckModeRequest(void) { return makePacket("QStartNoAckMode"); }
+	/* checks if a feature is reported as supported (i.e., as 'feature+') in a reply to a 'qSupported' request */
+	static bool isFeatureSupported(const QByteArray & reply, const QByteArray & feature)
+	{ return packetData(reply).split(';').contains(feature + '+'); }
 	static QByteArray memoryMapReadRequest(void) { return makePacket("qXfer:memory-map:read::0,400"); }
 	static QByteArray singleStepRequest(void) { return makePacket("s"); }
+	static QByteArray vContQueryRequest(void) { return makePacket("vCont?"); }
+	/* checks if an action is listed in a reply to a 'vCont?' request */
+	static bool isVContActionSupported(const QByteArray & reply, const QByteArray & action)
+	{ auto x = packetData(reply); return x.startsWith("vCont;") && x.split(';').mid(1).contains(action); }
+	static QByteArray rangeStepRequest(uint32_t start_address, uint32_t end_address) { return makePacket(QString("vCont;r%1,%2").arg(start_address, 0, 16).arg(end_address, 0, 16).toLocal8Bit()); }
 	static QByteArray continueRequest(void) { return makePacket("c"); }
 	static QByteArray resetRequest(void) { return makePacket("r"); }
 	static QByteArray setHardwareBreakpointRequest(uint32_t address, int length) { return makePacket(QString("Z1,%1,%2").arg(address, 0, 16).arg(length).toLocal8Bit()); }
@@ -95,28 +107,80 @@ public:
 		}
 		return registers;
 	}
-	static QVector<QByteArray> readMemoryRequest(uint32_t address, uint32_t length, int chunk_size = 1000)
+	/* a stop reply packet ('S', 'T', 'W' or 'X'), as sent when the target halts */
+	struct StopReply
 	{
-		QVector<QByteArray> packets;
-		while (length)
-		{
-			int x = Util::min(length, (unsigned) chunk_size);
-			packets.push_back(makePacket(QString("m%1,%2").arg(address, 0, 16).arg(x, 0, 16).toLocal8Bit()));
-			length -= x, address += x;
-		}
-		return packets;
-	}
-	static QByteArray readMemory(const QVector<QByteArray> & reply)
+		/* the packet type - this is zero if the packet is not a valid stop reply */
+		char	type;
+		/* the signal number for 'S' and 'T' packets, the exit status for 'W' packets */
+		int	signal;
+		/* the thread that stopped, or -1 if not reported */
+		int	thread;
+		/* the stop reason, if reported - e.g. 'watch', 'hwbreak', 'swbreak' */
+		QByteArray	reason;
+		/* the registers sent inline with a 'T' packet, keyed by register number */
+		QMap<int, uint32_t>	expedited_registers;
+	};
+	static struct StopReply parseStopReply(const QByteArray & packet)
 	{
-		QByteArray data;
+		struct StopReply reply;
+		reply.type = 0, reply.signal = reply.thread = -1;
+		auto x = packetData(packet);
 		int i;
-		for (i = 0; i < reply.size(); i ++)
+		bool ok;
+		if (x.length() < 3 || !strchr("STWX", x.at(0)))
+			return reply;
+		reply.signal = x.mid(1, 2).toInt(& ok, 16);
+		if (!ok)
+			return reply;
+		reply.type = x.at(0);
+		if (reply.type != 'T')
+			return reply;
+		auto fields = x.mid(3).split(';');
+		for (i = 0; i < fields.size(); i ++)
 		{
-			if (reply[i][0] == 'E')
-				return QByteArray();
-			data += QByteArray::fromHex(packetData(reply[i]));
+			int colon = fields.at(i).indexOf(':');
+			if (colon == -1)
+				continue;
+			auto name = fields.at(i).left(colon), value = fields.at(i).mid(colon + 1);
+			int register_number = name.toInt(& ok, 16);
+			if (ok && value.length() == 8)
+				reply.expedited_registers.insert(register_number, registerValue(value));
+			else if (name == "thread")
+				reply.thread = value.toInt(0, 16);
+			else if (name == "watch" || name == "rwatch" || name == "awatch" || name == "hwbreak" || name == "swbreak")
+				reply.reason = name;
 		}
-		return data;
+		return reply;
+	}
+	/* converts a hex encoded register value, in target (little endian) byte order */
+	static uint32_t registerValue(const QByteArray & hex)
+	{
+		uint32_t r = hex.toUInt(0, 16);
+		r = ((r & 0xffff) << 16) | (r >> 16);
+		return ((r & 0x00ff00ff) << 8) | ((r & 0xff00ff00) >> 8);
+	}
+	/* a read memory request - the reply is hex encoded */
+	static QByteArray readMemoryRequest(uint32_t address, uint32_t length) { return makePacket(QString("m%1,%2").arg(address, 0, 16).arg(length, 0, 16).toLocal8Bit()); }
+	static QByteArray readMemoryData(const QByteArray & reply) { return QByteArray::fromHex(packetData(reply)); }
+	/* a write memory request - the data is sent hex encoded */
+	static QByteArray writeMemoryRequest(uint32_t address, const QByteArray & data)
+	{ return makePacket(QString("M%1,%2:").arg(address, 0, 16).arg(data.length(), 0, 16).toLocal8Bit() + data.toHex()); }
+	/* a binary read memory request - the reply holds the memory contents as escaped binary data, which (depending
+	 * on the gdb server) may be preceded by a 'b' character; the reply may hold less data than requested, if
+	 * all of the requested data does not fit in a packet, after escaping it */
+	static QByteArray binaryReadMemoryRequest(uint32_t address, uint32_t length) { return makePacket(QString("x%1,%2").arg(address, 0, 16).arg(length, 0, 16).toLocal8Bit()); }
+	static QByteArray binaryReadMemoryData(const QByteArray & reply, bool is_prefixed) { return unescape(packetData(reply).mid(is_prefixed ? 1 : 0)); }
+	/* returns the maximum packet size from a reply to a 'qSupported' request, or -1 if the size is not reported */
+	static int packetSize(const QByteArray & reply)
+	{
+		auto features = packetData(reply).split(';');
+		int i, x;
+		bool ok;
+		for (i = 0; i < features.size(); i ++)
+			if (features.at(i).startsWith("PacketSize=") && (x = features.at(i).mid(strlen("PacketSize=")).toInt(& ok, 16), ok))
+				return x;
+		return -1;
 	}
 	static QVector<QByteArray> writeFlashMemoryRequest(uint32_t address, uint32_t length, const QByteArray & data, int chunk_size = 500)
 	{
@@ -130,6 +194,7 @@ public:
 		}
 		return packets;
 	}
+	static QByteArray flashDoneRequest(void) { return makePacket("vFlashDone"); }
 	static QByteArray eraseFlashMemoryRequest(uint32_t address, uint32_t length) { return makePacket(QString("vFlashErase:%1,%2").arg(address, 0, 16).arg(length, 0, 16).toLocal8Bit()); }
 	
 };
@@ -30,10 +30,10 @@ int DwarfData::readType(uint32_t die_offset, std::vector<struct DwarfTypeNode> &
 	if (reset_recursion_detector)
 		recursion_detector.clear();
 	uint32_t saved_die_offset(die_offset);
-	if (TYPE_DEBUG_ENABLED) qDebug() << "reading type die at offset" << QString("$%1").arg(die_offset, 0, 16);
+	if (TYPE_DEBUG_ENABLED) DwarfLog() << "reading type die at offset" << HEX(die_offset);
 	if (recursion_detector.operator [](saved_die_offset))
 	{
-		if (TYPE_DEBUG_ENABLED) qDebug() << "!!! type chain recursion detected";
+		if (TYPE_DEBUG_ENABLED) DwarfLog() << "!!! type chain recursion detected";
 		return recursion_detector.operator [](saved_die_offset);
 	}
 	auto type = debug_tree_of_die(die_offset);
@@ -73,13 +73,13 @@ int DwarfData::readType(uint32_t die_offset, std::vector<struct DwarfTypeNode> &
 		auto x = readTypeOffset(t.first, t.second, cu_offset);
                 i = readType(x, type_cache, false);
                 type_cache.at(index).next = i;
-                if (TYPE_DEBUG_ENABLED) qDebug() << "read type die at index " << i;
+                if (TYPE_DEBUG_ENABLED) DwarfLog() << "read type die at index " << i;
         }
 
 	if (type_cache.at(index).die.children.size())
 	{
 		int i, x;
-		if (TYPE_DEBUG_ENABLED) qDebug() << "aggregate type, child count" << type_cache.at(index).die.children.size();
+		if (TYPE_DEBUG_ENABLED) DwarfLog() << "aggregate type, child count" << type_cache.at(index).die.children.size();
 		x = readType(type_cache.at(index).die.children.at(0).offset, type_cache, false);
 		type_cache.at(index).children.push_back(x);
 		if (type_cache.at(x).die.tag == DW_TAG_subrange_type)
@@ -95,13 +95,13 @@ int DwarfData::readType(uint32_t die_offset, std::vector<struct DwarfTypeNode> &
 		}
 		for (i = 1; i < type_cache.at(index).die.children.size(); i ++)
 		{
-			if (TYPE_DEBUG_ENABLED) qDebug() << "reading type child" << i << ", offset is" << type_cache.at(index).die.children.at(i).offset;
+			if (TYPE_DEBUG_ENABLED) DwarfLog() << "reading type child" << i << ", offset is" << type_cache.at(index).die.children.at(i).offset;
 			x = readType(type_cache.at(index).die.children.at(i).offset, type_cache, false);
 			type_cache.at(index).children.push_back(x);
 		}
 	}
 	
-	if (TYPE_DEBUG_ENABLED) qDebug() << "done" << QString("$%1").arg(saved_die_offset, 0, 16);
+	if (TYPE_DEBUG_ENABLED) DwarfLog() << "done" << HEX(saved_die_offset);
 	return index;
 }
 
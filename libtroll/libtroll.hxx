@@ -22,97 +22,168 @@ THE SOFTWARE.
 
 #include <dwarf.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <list>
 #include <vector>
 #include <sstream>
-#include <QDebug>
+#include <memory>
+#include <algorithm>
 
-#define HEX(x) QString("$%1").arg(x, 8, 16, QChar('0'))
+#define HEX(x) DwarfLog::hex(x)
 
 #define DEBUG_ENABLED			0
 #define DEBUG_LINE_PROGRAMS_ENABLED	0
 #define DEBUG_DIE_READ_ENABLED		0
 #define DEBUG_ADDRESS_RANGE_ENABLED	0
+#define DEBUG_LOCATION_ENABLED		0
 #define UNWIND_DEBUG_ENABLED		0
 #define DWARF_EXPRESSION_TESTS_DEBUG_ENABLED		0
 
+/* define this to 0 to compile out all libtroll diagnostic messages */
+#ifndef LIBTROLL_LOG_ENABLED
+#define LIBTROLL_LOG_ENABLED		1
+#endif
+
 #define STATS_ENABLED			1
+/* the number of program counter values, for which execution context data is cached */
+#define PC_CONTEXT_CACHE_SIZE		64
+
+/* libtroll diagnostic messages - a message is collected in a temporary object, in the manner of DwarfLog(), and is
+ * passed to the installed sink when the object is destroyed; the default sink writes the messages to the standard
+ * error stream, applications can install their own sink with DwarfLog::setSink() */
+class DwarfLog
+{
+public:
+	typedef void (* Sink)(const char * message);
+	static void setSink(Sink sink) { DwarfLog::sink() = sink ? sink : defaultSink; }
+	static std::string hex(uint32_t x) { char s[16]; snprintf(s, sizeof s, "$%08x", (unsigned) x); return s; }
+#if LIBTROLL_LOG_ENABLED
+	DwarfLog(void) { is_empty = true; }
+	~DwarfLog(void) { sink()(message.str().c_str()); }
+	/* items are separated by spaces, just like with DwarfLog() */
+	template <typename T> DwarfLog & operator << (const T & x) { if (!is_empty) message << ' '; message << x; is_empty = false; return * this; }
+	/* print bytes as numbers, not as characters */
+	DwarfLog & operator << (uint8_t x) { return * this << (unsigned) x; }
+private:
+	std::ostringstream	message;
+	bool			is_empty;
+#else
+	template <typename T> DwarfLog & operator << (const T &) { return * this; }
+#endif
+private:
+	static void defaultSink(const char * message) { fprintf(stderr, "%s\n", message); }
+	static Sink & sink(void) { static Sink sink = defaultSink; return sink; }
+};
 
 class DwarfUtil
 {
 public:
 	static void panic(...) {*(int*)0=0;}
-	static uint32_t uleb128(const uint8_t * data, int * decoded_len)
-	{
-		uint64_t result = 0;
-		uint8_t x;
-		int shift = * decoded_len = 0;
-		do x = * data ++, result |= ((x & 0x7f) << shift), shift += 7, (* decoded_len) ++; while (x & 0x80);
-		/*
-		if (result > 0xffffffff)
-			panic();
-			*/
+	/* leb128 decoders - these are in the innermost loops of the dwarf parsing, so they are unrolled, with a
+	 * fast path for single byte values, which are by far the most common; decoded values are truncated to 32 bits */
+	static uint32_t uleb128_decode(const uint8_t * data, int & decoded_len)
+	{
+		uint32_t result = data[0];
+		if (!(result & 0x80))
+			return decoded_len = 1, result;
+		result = (result & 0x7f) | ((uint32_t) (data[1] & 0x7f) << 7);
+		if (!(data[1] & 0x80))
+			return decoded_len = 2, result;
+		result |= (uint32_t) (data[2] & 0x7f) << 14;
+		if (!(data[2] & 0x80))
+			return decoded_len = 3, result;
+		result |= (uint32_t) (data[3] & 0x7f) << 21;
+		if (!(data[3] & 0x80))
+			return decoded_len = 4, result;
+		result |= (uint32_t) data[4] << 28;
+		/* skip any padding bytes of an overlong encoding */
+		for (decoded_len = 5; data[decoded_len - 1] & 0x80; decoded_len ++)
+			;
 		return result;
 	}
-	static uint32_t uleb128(const uint8_t * data)
+	static int32_t sleb128_decode(const uint8_t * data, int & decoded_len)
 	{
-		uint64_t result = 0;
+		uint32_t result = data[0];
 		uint8_t x;
-		int shift = 0;
-		do x = * data ++, result |= ((x & 0x7f) << shift), shift += 7; while (x & 0x80);
-		/*
-		if (result > 0xffffffff)
-			panic();
-			*/
+		int shift;
+		if (!(result & 0x80))
+			/* sign extend bit 6 */
+			return decoded_len = 1, (int32_t) (result ^ 0x40) - 0x40;
+		result = 0, shift = decoded_len = 0;
+		do
+		{
+			x = data[decoded_len ++];
+			if (shift < 32)
+				result |= (uint32_t) (x & 0x7f) << shift;
+			shift += 7;
+		}
+		while (x & 0x80);
+		/* propagate sign bit */
+		if ((x & 0x40) && shift < 32)
+			result |= ~ (uint32_t) 0 << shift;
 		return result;
 	}
+	static uint32_t uleb128(const uint8_t * data, int * decoded_len) { return uleb128_decode(data, * decoded_len); }
+	static uint32_t uleb128(const uint8_t * data) { int decoded_len; return uleb128_decode(data, decoded_len); }
 	static uint32_t uleb128x(const uint8_t * & data)
 	{
-		uint64_t result = 0;
-		uint8_t x;
-		int shift = 0;
-		do x = * data ++, result |= ((x & 0x7f) << shift), shift += 7; while (x & 0x80);
-		/*
-		if (result > 0xffffffff)
-			panic();
-			*/
+		/* fast path for the very common case of decoding abbreviation attribute names and forms */
+		if (!(* data & 0x80))
+			return * data ++;
+		int decoded_len;
+		uint32_t result = uleb128_decode(data, decoded_len);
+		data += decoded_len;
 		return result;
 	}
-	static int32_t sleb128(const uint8_t * data, int * decoded_len)
+	static int32_t sleb128(const uint8_t * data, int * decoded_len) { return sleb128_decode(data, * decoded_len); }
+	static int32_t sleb128(const uint8_t * data) { int decoded_len; return sleb128_decode(data, decoded_len); }
+	/* returns the size of the data for an attribute form, if it is the same for all attributes with this form,
+	 * otherwise returns -1 */
+	static int fixedFormSize(uint32_t form)
 	{
-		uint64_t result = 0;
-		uint8_t x;
-		int shift = * decoded_len = 0;
-		do x = * data ++, result |= ((x & 0x7f) << shift), shift += 7, (* decoded_len) ++; while (x & 0x80);
-		/*
-		if (result > 0xffffffff)
-			panic();
-			*/
-		/* handle sign */
-		if (x & 0x40)
-			/* propagate sign bit */
-			result |= - 1 << (shift - 1);
-		return result;
-	}
-	static int32_t sleb128(const uint8_t * data)
-	{
-		uint64_t result = 0;
-		uint8_t x;
-		int shift = 0;
-		do x = * data ++, result |= ((x & 0x7f) << shift), shift += 7; while (x & 0x80);
-		/*
-		if (result > 0xffffffff)
-			panic();
-			*/
-		/* handle sign */
-		if (x & 0x40)
-			/* propagate sign bit */
-			result |= - 1 << (shift - 1);
-		return result;
+		static const int8_t sizes[] =
+		{
+			/* 0x00 */ -1,
+			/* DW_FORM_addr */ 4,
+			/* 0x02 */ -1,
+			/* DW_FORM_block2 */ -1,
+			/* DW_FORM_block4 */ -1,
+			/* DW_FORM_data2 */ 2,
+			/* DW_FORM_data4 */ 4,
+			/* DW_FORM_data8 */ 8,
+			/* DW_FORM_string */ -1,
+			/* DW_FORM_block */ -1,
+			/* DW_FORM_block1 */ -1,
+			/* DW_FORM_data1 */ 1,
+			/* DW_FORM_flag */ 1,
+			/* DW_FORM_sdata */ -1,
+			/* DW_FORM_strp */ 4,
+			/* DW_FORM_udata */ -1,
+			/* DW_FORM_ref_addr */ 4,
+			/* DW_FORM_ref1 */ 1,
+			/* DW_FORM_ref2 */ 2,
+			/* DW_FORM_ref4 */ 4,
+			/* DW_FORM_ref8 */ 8,
+			/* DW_FORM_ref_udata */ -1,
+			/* DW_FORM_indirect */ -1,
+			/* DW_FORM_sec_offset */ 4,
+			/* DW_FORM_exprloc */ -1,
+			/* DW_FORM_flag_present */ 0,
+			/* 0x1a - 0x1f */ -1, -1, -1, -1, -1, -1,
+			/* DW_FORM_ref_sig8 */ 8,
+		};
+		return form < sizeof sizes / sizeof * sizes ? sizes[form] : -1;
 	}
 	static int skip_form_bytes(int form, const uint8_t * debug_info_bytes)
 	{
-		int bytes_to_skip;
+		int bytes_to_skip = fixedFormSize(form);
+		if (bytes_to_skip >= 0)
+			return bytes_to_skip;
 		switch (form)
 		{
 		default:
@@ -201,7 +272,7 @@ public:
 		switch (attribute_form)
 		{
 		case DW_FORM_ref_addr:
-			qDebug() << "!!! referenced die is in another compilation unit; must update abbreviation cache !!!";
+			DwarfLog() << "!!! referenced die is in another compilation unit; must update abbreviation cache !!!";
 			return * (uint32_t *) debug_info_bytes;
 		case DW_FORM_ref4:
 			return * (uint32_t *) debug_info_bytes + compilation_unit_header_offset;
@@ -274,6 +345,20 @@ struct Die
 	bool isLexicalBlock(void) const { return tag == DW_TAG_lexical_block; }
 };
 
+/* a die, that covers a range of target addresses - a compilation unit, a subprogram, a lexical block or an inlined
+ * subroutine; these are the dies that can make up the execution context for an address, and are recorded in the
+ * address range table of DwarfData, so that execution context queries do not need to read and scan any dies */
+struct ContextNode
+{
+	uint32_t	die_offset;
+	uint32_t	abbrev_offset;
+	uint32_t	tag;
+	/* index of the node of the enclosing die; -1 for compilation units */
+	int		parent;
+	int		depth;
+	struct Die die(void) const { return Die(tag, die_offset, abbrev_offset); }
+};
+
 /* !!! warning - this can generally be a circular graph - beware of recursion when processing !!! */
 struct DwarfTypeNode
 {
@@ -761,18 +846,18 @@ public:
 		init();
 		if (DEBUG_LINE_PROGRAMS_ENABLED)
 		{
-			qDebug() << "debug line for offset" << HEX(header - debug_line);
-			qDebug() << "include directories table:";
+			DwarfLog() << "debug line for offset" << HEX(header - debug_line);
+			DwarfLog() << "include directories table:";
 			union { const char * s; const uint8_t * p; } x;
 			x.s = include_directories();
 			size_t l;
 			while ((l = strlen(x.s)))
-				qDebug() << QString(x.s), x.s += l + 1;
-			qDebug() << "file names table:";
+				DwarfLog() << x.s, x.s += l + 1;
+			DwarfLog() << "file names table:";
 			x.s = file_names();
 			while ((l = strlen(x.s)))
 			{
-				qDebug() << QString(x.s), x.s += l + 1;
+				DwarfLog() << x.s, x.s += l + 1;
 				/* skip directory index, file time and file size */
 				DwarfUtil::uleb128x(x.p), DwarfUtil::uleb128x(x.p), DwarfUtil::uleb128x(x.p);
 			}
@@ -793,7 +878,7 @@ public:
 					case DW_LNE_set_discriminator:
 				{
 						auto d = DwarfUtil::uleb128(p, & x);
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set discriminator to" << d << "!!! IGNORED !!!";
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set discriminator to" << d << "!!! IGNORED !!!";
 						if (len != x + 1) DwarfUtil::panic();
 						p += x;
 				}
@@ -801,13 +886,13 @@ public:
 					case DW_LNE_end_sequence:
 						if (len != 1) DwarfUtil::panic();
 						init();
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "end of sequence";
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "end of sequence";
 						break;
 					case DW_LNE_set_address:
 						if (len != 5) DwarfUtil::panic();
 						current->address = * (uint32_t *) p;
 						p += sizeof current->address;
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "extended opcode, set address to" << HEX(current->address);
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "extended opcode, set address to" << HEX(current->address);
 						break;
 				}
 			}
@@ -817,7 +902,7 @@ public:
 				uint8_t x = * p ++ - op_base;
 				current->address += (x / lrange) * min_insn_length;
 				current->line += lbase + x % lrange;
-				if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "special opcode, set address to" << HEX(current->address) << "line to" << current->line;
+				if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "special opcode, set address to" << HEX(current->address) << "line to" << current->line;
 				swap();
 				* current = * prev;
 			}
@@ -828,45 +913,45 @@ public:
 					DwarfUtil::panic();
 					break;
 				case DW_LNS_set_prologue_end:
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set prologue end to true";
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set prologue end to true";
 					break;
 				case DW_LNS_copy:
 				/*
 					if (xaddr <= target_address && target_address < address)
 						DwarfUtil::panic();*/
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "copy";
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "copy";
 					swap();
 					* current = * prev;
 					break;
 				case DW_LNS_advance_pc:
 					current->address += DwarfUtil::uleb128(p, & len) * min_insn_length;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance pc to" << HEX(current->address);
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance pc to" << HEX(current->address);
 					p += len;
 					break;
 				case DW_LNS_advance_line:
 					current->line += DwarfUtil::sleb128(p, & len);
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance line to" << current->line;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance line to" << current->line;
 					break;
 				case DW_LNS_const_add_pc:
 					current->address += ((255 - op_base) / lrange) * min_insn_length;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance pc to" << HEX(current->address);
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance pc to" << HEX(current->address);
 					break;
 				case DW_LNS_set_file:
 					current->file = DwarfUtil::uleb128(p, & len);
 					if (!current->file)
 						DwarfUtil::panic();
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set file to" << current->file;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set file to" << current->file;
 					break;
 				case DW_LNS_set_column:
 					current->column = DwarfUtil::uleb128(p, & len);
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set column to" << current->column;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set column to" << current->column;
 					break;
 				case DW_LNS_negate_stmt:
 					current->is_stmt = ! current->is_stmt;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set is_stmt to " << current->is_stmt;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set is_stmt to " << current->is_stmt;
 					break;
 			}
 		}
@@ -884,18 +969,18 @@ public:
 		is_address_on_exact_line_number_boundary = false;
 		if (DEBUG_LINE_PROGRAMS_ENABLED)
 		{
-			qDebug() << "debug line for offset" << HEX(header - debug_line);
-			qDebug() << "include directories table:";
+			DwarfLog() << "debug line for offset" << HEX(header - debug_line);
+			DwarfLog() << "include directories table:";
 			union { const char * s; const uint8_t * p; } x;
 			x.s = include_directories();
 			size_t l;
 			while ((l = strlen(x.s)))
-				qDebug() << QString(x.s), x.s += l + 1;
-			qDebug() << "file names table:";
+				DwarfLog() << x.s, x.s += l + 1;
+			DwarfLog() << "file names table:";
 			x.s = file_names();
 			while ((l = strlen(x.s)))
 			{
-				qDebug() << QString(x.s), x.s += l + 1;
+				DwarfLog() << x.s, x.s += l + 1;
 				/* skip directory index, file time and file size */
 				DwarfUtil::uleb128x(x.p), DwarfUtil::uleb128x(x.p), DwarfUtil::uleb128x(x.p);
 			}
@@ -914,7 +999,7 @@ public:
 					default:
 						DwarfUtil::panic();
 					case DW_LNE_set_discriminator:
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set discriminator to" << DwarfUtil::uleb128(p, & x) << "!!! IGNORED !!!";
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set discriminator to" << DwarfUtil::uleb128(p, & x) << "!!! IGNORED !!!";
 						if (len != x + 1) DwarfUtil::panic();
 						p += x;
 						break;
@@ -927,13 +1012,13 @@ public:
 							return file_number = prev->file, prev->line;
 						}
 						init();
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "end of sequence";
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "end of sequence";
 						break;
 					case DW_LNE_set_address:
 						if (len != 5) DwarfUtil::panic();
 						current->address = * (uint32_t *) p;
 						p += sizeof current->address;
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "extended opcode, set address to" << HEX(current->address);
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "extended opcode, set address to" << HEX(current->address);
 						break;
 				}
 			}
@@ -949,7 +1034,7 @@ public:
 						is_address_on_exact_line_number_boundary = true;
 					return file_number = prev->file, prev->line;
 				}
-				if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "special opcode, set address to" << HEX(current->address) << "line to" << current->line;
+				if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "special opcode, set address to" << HEX(current->address) << "line to" << current->line;
 				swap();
 				* current = * prev;
 			}
@@ -963,7 +1048,7 @@ public:
 				/*
 					if (xaddr <= target_address && target_address < address)
 						DwarfUtil::panic();*/
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "copy";
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "copy";
 					if (prev->address <= target_address && target_address < current->address)
 					{
 						if (prev->address == target_address)
@@ -975,37 +1060,193 @@ public:
 					break;
 				case DW_LNS_advance_pc:
 					current->address += DwarfUtil::uleb128(p, & len) * min_insn_length;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance pc to" << HEX(current->address);
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance pc to" << HEX(current->address);
 					p += len;
 					break;
 				case DW_LNS_advance_line:
 					current->line += DwarfUtil::sleb128(p, & len);
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance line to" << current->line;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance line to" << current->line;
 					break;
 				case DW_LNS_const_add_pc:
 					current->address += ((255 - op_base) / lrange) * min_insn_length;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance pc to" << HEX(current->address);
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance pc to" << HEX(current->address);
 					break;
 				case DW_LNS_set_file:
 					current->file = DwarfUtil::uleb128(p, & len);
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set file to" << current->file;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set file to" << current->file;
 					break;
 				case DW_LNS_set_column:
 					current->column = DwarfUtil::uleb128(p, & len);
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set column to" << current->column;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set column to" << current->column;
 					break;
 				case DW_LNS_negate_stmt:
 					current->is_stmt = ! current->is_stmt;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set is_stmt to " << current->is_stmt;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set is_stmt to " << current->is_stmt;
 					break;
 			}
 		}
 		return file_number = 0, -1;
 	}
 
+	/* runs the line number program at 'statement_list_offset', and calls 'row(is_end_of_sequence)' for each row appended
+	 * to the line number matrix - 'prev' then holds the row, and 'current->address' is the address that follows the row;
+	 * the rows for empty address ranges are also reported; the program is stopped if 'row()' returns false */
+	template <typename RowCallback> void runLineNumberProgram(uint32_t statement_list_offset, RowCallback row)
+	{
+		header = debug_line + statement_list_offset;
+		if (version() != 2) DwarfUtil::panic();
+		const uint8_t * p(line_number_program()), op_base(opcode_base()), lrange(line_range());
+		int lbase(line_base());
+		uint32_t min_insn_length(minimum_instruction_length());
+		int len, x;
+		init();
+		while (p < header + sizeof(uint32_t) + unit_length())
+		{
+			if (! * p)
+			{
+				/* extended opcodes */
+				len = DwarfUtil::uleb128(++ p, & x);
+				p += x;
+				if (!len)
+					DwarfUtil::panic();
+				switch (* p ++)
+				{
+					default:
+						DwarfUtil::panic();
+					case DW_LNE_set_discriminator:
+						DwarfUtil::uleb128(p, & x);
+						if (len != x + 1) DwarfUtil::panic();
+						p += x;
+						break;
+					case DW_LNE_end_sequence:
+						if (len != 1) DwarfUtil::panic();
+						if (!row(true))
+							return;
+						init();
+						break;
+					case DW_LNE_set_address:
+						if (len != 5) DwarfUtil::panic();
+						current->address = * (uint32_t *) p;
+						p += sizeof current->address;
+						break;
+				}
+			}
+			else if (* p >= op_base)
+			{
+				/* special opcodes */
+				uint8_t x = * p ++ - op_base;
+				current->address += (x / lrange) * min_insn_length;
+				current->line += lbase + x % lrange;
+				if (!row(false))
+					return;
+				swap();
+				* current = * prev;
+			}
+			/* standard opcodes */
+			else switch (* p ++)
+			{
+				default:
+					DwarfUtil::panic();
+					break;
+				case DW_LNS_set_prologue_end:
+					break;
+				case DW_LNS_copy:
+					if (!row(false))
+						return;
+					swap();
+					* current = * prev;
+					break;
+				case DW_LNS_advance_pc:
+					current->address += DwarfUtil::uleb128(p, & len) * min_insn_length;
+					p += len;
+					break;
+				case DW_LNS_advance_line:
+					current->line += DwarfUtil::sleb128(p, & len);
+					p += len;
+					break;
+				case DW_LNS_const_add_pc:
+					current->address += ((255 - op_base) / lrange) * min_insn_length;
+					break;
+				case DW_LNS_set_file:
+					current->file = DwarfUtil::uleb128(p, & len);
+					p += len;
+					break;
+				case DW_LNS_set_column:
+					current->column = DwarfUtil::uleb128(p, & len);
+					p += len;
+					break;
+				case DW_LNS_negate_stmt:
+					current->is_stmt = ! current->is_stmt;
+					break;
+			}
+		}
+	}
+
+	/* computes the address range of the source code line that contains 'target_address' - this is the row of the line
+	 * number program that contains the address, merged with the adjacent rows (in the same sequence) for the same file
+	 * and line number; returns false if the address is not covered by the line number program at 'statement_list_offset' */
+	bool lineAddressRangeForAddress(uint32_t statement_list_offset, uint32_t target_address, uint32_t & start_address, uint32_t & end_address)
+	{
+		bool is_found = false;
+		/* the current run of adjacent rows for the same file and line number */
+		uint32_t run_start = -1, run_end = -1, run_file = 0;
+		int run_line = -1;
+		runLineNumberProgram(statement_list_offset, [&] (bool is_end_of_sequence) -> bool
+		{
+			if (prev->address < current->address)
+			{
+				if (!is_found)
+				{
+					if (prev->file != run_file || prev->line != run_line || prev->address != run_end)
+						run_start = prev->address, run_file = prev->file, run_line = prev->line;
+					run_end = current->address;
+					if (prev->address <= target_address && target_address < current->address)
+						is_found = true, start_address = run_start, end_address = current->address;
+				}
+				else if (prev->file == run_file && prev->line == run_line && prev->address == end_address)
+					end_address = current->address;
+				else
+					return false;
+			}
+			if (is_end_of_sequence)
+			{
+				if (is_found)
+					return false;
+				run_end = -1;
+			}
+			return true;
+		});
+		return is_found;
+	}
+
+	struct lineNumber { uint32_t file, line; bool is_address_on_exact_line_number_boundary; };
+	/* resolves the line numbers for a whole batch of addresses, in a single pass over the line number program
+	 * at 'statement_list_offset'; the addresses must be sorted in ascending order; the result for address
+	 * 'addresses[i]' is stored in 'line_numbers[i]' - for addresses not covered by the line number program,
+	 * the file number is set to 0, and the line number is set to -1 */
+	void lineNumbersForAddresses(uint32_t statement_list_offset, const uint32_t * addresses, int address_count, struct lineNumber * line_numbers)
+	{
+		int i;
+		for (i = 0; i < address_count; i ++)
+			line_numbers[i] = (struct lineNumber) { .file = 0, .line = (uint32_t) -1, .is_address_on_exact_line_number_boundary = false, };
+		/* assigns each row to all addresses inside it, that do not have a line number assigned yet; this matches
+		 * the behavior of lineNumberForAddress(), which returns the first row containing an address */
+		runLineNumberProgram(statement_list_offset, [&] (bool) -> bool
+		{
+			if (!(prev->address < current->address))
+				return true;
+			int i = std::lower_bound(addresses, addresses + address_count, prev->address) - addresses;
+			for (; i < address_count && addresses[i] < current->address; i ++)
+				if (line_numbers[i].line == (uint32_t) -1)
+					line_numbers[i] = (struct lineNumber) { .file = prev->file, .line = (uint32_t) prev->line,
+							.is_address_on_exact_line_number_boundary = (addresses[i] == prev->address), };
+			return true;
+		});
+	}
+
 	void addressesForFile(uint32_t file_number, std::vector<struct lineAddress> & line_addresses)
 	{
 		if (version() != 2) DwarfUtil::panic();
@@ -1017,18 +1258,18 @@ public:
 		struct lineAddress line_data;
 		if (DEBUG_LINE_PROGRAMS_ENABLED)
 		{
-			qDebug() << "debug line for offset" << HEX(header - debug_line);
-			qDebug() << "include directories table:";
+			DwarfLog() << "debug line for offset" << HEX(header - debug_line);
+			DwarfLog() << "include directories table:";
 			union { const char * s; const uint8_t * p; } x;
 			x.s = include_directories();
 			size_t l;
 			while ((l = strlen(x.s)))
-				qDebug() << QString(x.s), x.s += l + 1;
-			qDebug() << "file names table:";
+				DwarfLog() << x.s, x.s += l + 1;
+			DwarfLog() << "file names table:";
 			x.s = file_names();
 			while ((l = strlen(x.s)))
 			{
-				qDebug() << QString(x.s), x.s += l + 1;
+				DwarfLog() << x.s, x.s += l + 1;
 				/* skip directory index, file time and file size */
 				DwarfUtil::uleb128x(x.p), DwarfUtil::uleb128x(x.p), DwarfUtil::uleb128x(x.p);
 			}
@@ -1047,7 +1288,7 @@ public:
 					default:
 						DwarfUtil::panic();
 					case DW_LNE_set_discriminator:
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set discriminator to" << DwarfUtil::uleb128(p, & x) << "!!! IGNORED !!!";
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set discriminator to" << DwarfUtil::uleb128(p, & x) << "!!! IGNORED !!!";
 						if (len != x + 1) DwarfUtil::panic();
 						p += x;
 						break;
@@ -1061,13 +1302,13 @@ public:
 							line_addresses.push_back(line_data);
 						}
 						init();
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "end of sequence";
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "end of sequence";
 						break;
 					case DW_LNE_set_address:
 						if (len != 5) DwarfUtil::panic();
 						current->address = * (uint32_t *) p;
 						p += sizeof current->address;
-						if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "extended opcode, set address to" << HEX(current->address);
+						if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "extended opcode, set address to" << HEX(current->address);
 						break;
 				}
 			}
@@ -1084,7 +1325,7 @@ public:
 					line_data.address_span = current->address;
 					line_addresses.push_back(line_data);
 				}
-				if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "special opcode, set address to" << HEX(current->address) << "line to" << current->line;
+				if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "special opcode, set address to" << HEX(current->address) << "line to" << current->line;
 				swap();
 				* current = * prev;
 			}
@@ -1094,10 +1335,10 @@ public:
 				default:
 					break;
 				case DW_LNS_set_prologue_end:
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set prologue end to true";
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set prologue end to true";
 					break;
 				case DW_LNS_copy:
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "copy";
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "copy";
 					if (prev->file == file_number)
 					{
 						line_data.address = prev->address;
@@ -1110,31 +1351,31 @@ public:
 					break;
 				case DW_LNS_advance_pc:
 					current->address += DwarfUtil::uleb128(p, & len) * min_insn_length;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance pc to" << HEX(current->address);
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance pc to" << HEX(current->address);
 					p += len;
 					break;
 				case DW_LNS_advance_line:
 					current->line += DwarfUtil::sleb128(p, & len);
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance line to" << current->line;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance line to" << current->line;
 					break;
 				case DW_LNS_const_add_pc:
 					current->address += ((255 - op_base) / lrange) * min_insn_length;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "advance pc to" << HEX(current->address);
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "advance pc to" << HEX(current->address);
 					break;
 				case DW_LNS_set_file:
 					current->file = DwarfUtil::uleb128(p, & len);
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set file to" << current->file;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set file to" << current->file;
 					break;
 				case DW_LNS_set_column:
 					current->column = DwarfUtil::uleb128(p, & len);
 					p += len;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set column to" << current->column;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set column to" << current->column;
 					break;
 				case DW_LNS_negate_stmt:
 					current->is_stmt = ! current->is_stmt;
-					if (DEBUG_LINE_PROGRAMS_ENABLED) qDebug() << "set is_stmt to " << current->is_stmt;
+					if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << "set is_stmt to " << current->is_stmt;
 					break;
 			}
 		}
@@ -1189,7 +1430,7 @@ public:
 	}
 	void getFileAndDirectoryNamesPointers(std::vector<struct sourceFileNames> & sources, const char * compilation_directory)
 	{
-		qDebug() << (uint32_t) (header - debug_line);
+		if (DEBUG_LINE_PROGRAMS_ENABLED) DwarfLog() << (uint32_t) (header - debug_line);
 		std::vector<const char *> directories;
 		union { const char * s; const uint8_t * p; } x;
 		x.s = include_directories();
@@ -1237,15 +1478,19 @@ private:
 	const uint8_t * debug_loc;
 	uint32_t	debug_loc_len;
 
+	/* per query context state - the members below are caches and statistics, that are updated by
+	 * the (otherwise read-only) queries, so a DwarfData instance must not be used by more than one
+	 * thread at a time; to run queries concurrently, give each thread its own query context, see the
+	 * copy constructor below */
 	struct debug_arange arange;
 	/* cached for performance reasons */
 	const uint8_t	* last_searched_arange;
 	struct compilation_unit_header last_searched_compilation_unit;
 	
-	struct
+public:
+	/* query statistics - these are only updated if 'STATS_ENABLED' is nonzero */
+	struct QueryStatistics
 	{
-		unsigned total_dies;
-		unsigned total_compilation_units;
 		unsigned dies_read;
 		unsigned compilation_unit_arange_hits;
 		unsigned compilation_unit_arange_misses;
@@ -1253,22 +1498,96 @@ private:
 		unsigned compilation_unit_header_misses;
 		unsigned abbreviation_hits;
 		unsigned abbreviation_misses;
-	}
-	stats;
+		unsigned pc_context_hits;
+		unsigned pc_context_misses;
+		unsigned frame_descriptor_hits;
+		unsigned frame_descriptor_misses;
+	};
+private:
+	struct QueryStatistics stats;
+	std::map<uint32_t, uint32_t> recursion_detector;
+
 	struct DieFingerprint
 	{
 		uint32_t	offset;
 		uint32_t	abbrev_offset;
 	};
-	std::vector<struct DieFingerprint> die_fingerprints;
-	uint32_t abbreviationOffsetForDieOffset(uint32_t die_offset)
+	/* the debug information index - built once, by the constructor, and never modified afterwards; it is
+	 * shared by all query contexts created from one another, so it must only contain immutable data */
+	struct DwarfIndex
+	{
+		std::vector<struct DieFingerprint> die_fingerprints;
+		unsigned total_dies;
+		unsigned total_compilation_units;
+		/* the address range table - all dies that cover target addresses, in .debug_info order, and a partition
+		 * of the target address space in segments, sorted by start address; each segment extends up to the
+		 * start of the next segment, and refers to the innermost context node covering the segment, or is -1
+		 * for addresses not covered by any context node */
+		std::vector<struct ContextNode> context_nodes;
+		struct ContextSegment { uint32_t start; int node; bool operator < (uint32_t address) const { return start < address; } };
+		std::vector<struct ContextSegment> context_segments;
+		/* gnu call site dies, sorted by return address; the parameters of a call site are 'parameter_count' consecutive
+		 * entries in 'call_site_parameters', starting at 'first_parameter' */
+		struct CallSite { uint32_t address; uint32_t die_offset; uint32_t abbrev_offset; int first_parameter; int parameter_count;
+			bool operator < (uint32_t address) const { return this->address < address; } };
+		std::vector<struct CallSite> call_sites;
+		struct CallSiteParameterEntry { uint32_t die_offset; uint32_t abbrev_offset; int register_number; };
+		std::vector<struct CallSiteParameterEntry> call_site_parameters;
+		/* the size of the attribute data of the dies that use an abbreviation, keyed by the offset of the abbreviation
+		 * in .debug_abbrev; this is -1 if any attribute of the abbreviation has a variable size form - otherwise,
+		 * the attributes of a die can be skipped with a single addition, without walking the abbreviation */
+		std::unordered_map<uint32_t, int> abbreviation_data_sizes;
+		/* the source files of all line number programs, without duplicates (source files with the same file and
+		 * directory names are considered duplicates), sorted by file name, and then by directory name */
+		std::vector<struct DebugLine::sourceFileNames> source_files;
+		DwarfIndex(void) { total_dies = total_compilation_units = 0; }
+	};
+	std::shared_ptr<const struct DwarfIndex> index;
+	/* scratch data, only used while building the debug information index */
+	struct IndexBuilder
+	{
+		struct DwarfIndex	* index;
+		uint32_t		compilation_unit_base_address;
+		struct AddressRange { uint32_t low, high; int node; };
+		std::vector<struct AddressRange> ranges;
+		/* the index of the call site whose parameters are being recorded, or -1 */
+		int current_call_site;
+		/* the abbreviations of the compilation unit being processed, keyed by abbreviation code */
+		struct AbbreviationCode { uint32_t abbrev_offset; int data_size; };
+		std::map<uint32_t, struct AbbreviationCode> abbreviations;
+	};
+	void resetQueryContext(void)
+	{
+		arange = debug_arange(debug_aranges);
+		last_searched_compilation_unit.data = debug_info;
+		last_searched_arange = arange.data;
+		memset(& stats, 0, sizeof stats);
+		recursion_detector.clear();
+		pc_context_lru.clear();
+		pc_contexts.clear();
+		frame_descriptors.clear();
+	}
+	/* returns a pointer past the attribute data of a die, 'debug_info_data' must point to the attribute
+	 * data of the die, i.e. past the abbreviation code of the die */
+	static const uint8_t * skipAttributes(struct Abbreviation & a, const uint8_t * debug_info_data)
+	{
+		auto attr = a.next_attribute();
+		while (attr.first)
+		{
+			debug_info_data += DwarfUtil::skip_form_bytes(attr.second, debug_info_data);
+			attr = a.next_attribute();
+		}
+		return debug_info_data;
+	}
+	int fingerprintIndexForDieOffset(uint32_t die_offset)
 	{
+		const std::vector<struct DieFingerprint> & die_fingerprints(index->die_fingerprints);
 		int l = 0, h = die_fingerprints.size() - 1, m;
 		while (l <= h)
 		{
 			m = (l + h) >> 1;
 			if (die_fingerprints.at(m).offset == die_offset)
-				return die_fingerprints.at(m).abbrev_offset;
+				return m;
 			if (die_fingerprints.at(m).offset < die_offset)
 				l = m + 1;
 			else
@@ -1276,36 +1595,185 @@ private:
 		}
 		DwarfUtil::panic();
 	}
+	uint32_t abbreviationOffsetForDieOffset(uint32_t die_offset)
+	{
+		return index->die_fingerprints.at(fingerprintIndexForDieOffset(die_offset)).abbrev_offset;
+	}
 	
-	/* first number is the abbreviation code, the second is the offset in .debug_abbrev */
-	void getAbbreviationsOfCompilationUnit(uint32_t compilation_unit_offset, std::map<uint32_t, uint32_t> & abbreviations)
+	/* reads the abbreviations of a compilation unit in 'builder.abbreviations', and records their
+	 * attribute data sizes in the index */
+	void getAbbreviationsOfCompilationUnit(uint32_t compilation_unit_offset, struct IndexBuilder & builder)
 	{
 		if (STATS_ENABLED) stats.abbreviation_misses ++;
 		const uint8_t * debug_abbrev = this->debug_abbrev + compilation_unit_header((uint8_t *) debug_info + compilation_unit_offset) . debug_abbrev_offset(); 
-		uint32_t code, name, form;
-		int len;
-		abbreviations.clear();
+		uint32_t code, name, form, abbrev_offset;
+		int len, data_size, form_size;
+		builder.abbreviations.clear();
 		while ((code = DwarfUtil::uleb128(debug_abbrev, & len)))
 		{
-			auto x = abbreviations.find(code);
-			if (x != abbreviations.end())
+			auto x = builder.abbreviations.find(code);
+			if (x != builder.abbreviations.end())
 				DwarfUtil::panic("duplicate abbreviation code");
-			abbreviations.operator [](code) = debug_abbrev - this->debug_abbrev;
+			abbrev_offset = debug_abbrev - this->debug_abbrev;
 			debug_abbrev += len;
 			/* skip die tag and children flag */
 			DwarfUtil::uleb128x(debug_abbrev), DwarfUtil::uleb128x(debug_abbrev);
-			do
+			data_size = 0;
+			while (1)
 			{
 				name = DwarfUtil::uleb128x(debug_abbrev);
 				form = DwarfUtil::uleb128x(debug_abbrev);
+				if (!name && !form)
+					break;
+				if (data_size != -1)
+					data_size = ((form_size = DwarfUtil::fixedFormSize(form)) == -1) ? -1 : data_size + form_size;
+			}
+			builder.abbreviations.operator [](code) = (struct IndexBuilder::AbbreviationCode) { .abbrev_offset = abbrev_offset, .data_size = data_size, };
+			builder.index->abbreviation_data_sizes.operator [](abbrev_offset) = data_size;
+		}
+	}
+
+	/* appends the address ranges covered by a die to 'ranges' - the first number in a pair is the start address,
+	 * the second number is the end address (exclusive); 'base_address' is the initial base address for
+	 * range lists - the low pc of the compilation unit containing the die */
+	void addressRangesOfDie(uint32_t die_offset, uint32_t abbrev_offset, uint32_t base_address, std::vector<std::pair<uint32_t, uint32_t> > & ranges)
+	{
+		struct Abbreviation a(debug_abbrev + abbrev_offset);
+		auto range = a.dataForAttribute(DW_AT_ranges, debug_info + die_offset);
+		if (range.first)
+		{
+			const uint32_t * range_list = (const uint32_t *) (debug_ranges + DwarfUtil::formConstant(range));
+			while (range_list[0] || range_list[1])
+			{
+				if (range_list[0] == -1)
+					base_address = range_list[1];
+				else
+					ranges.push_back(std::pair<uint32_t, uint32_t>(range_list[0] + base_address, range_list[1] + base_address));
+				range_list += 2;
 			}
-			while (name || form);
+			return;
+		}
+		auto low_pc = a.dataForAttribute(DW_AT_low_pc, debug_info + die_offset);
+		auto hi_pc = a.dataForAttribute(DW_AT_high_pc, debug_info + die_offset);
+		if (low_pc.first && hi_pc.first)
+		{
+			uint32_t x = DwarfUtil::fetchHighLowPC(low_pc.first, low_pc.second);
+			ranges.push_back(std::pair<uint32_t, uint32_t>(x, DwarfUtil::fetchHighLowPC(hi_pc.first, hi_pc.second, x)));
+		}
+	}
+	/* records a die in the address range table, if it covers any addresses; returns the index
+	 * of the node created for the die, or 'parent_node' if no node was created */
+	int recordContextNode(struct IndexBuilder & builder, uint32_t die_offset, uint32_t abbrev_offset, uint32_t tag, int parent_node)
+	{
+		std::vector<std::pair<uint32_t, uint32_t> > ranges;
+		int i, node;
+		if (tag == DW_TAG_compile_unit)
+		{
+			struct Abbreviation a(debug_abbrev + abbrev_offset);
+			auto low_pc = a.dataForAttribute(DW_AT_low_pc, debug_info + die_offset);
+			builder.compilation_unit_base_address = low_pc.first ? DwarfUtil::fetchHighLowPC(low_pc.first, low_pc.second) : 0;
+		}
+		addressRangesOfDie(die_offset, abbrev_offset, builder.compilation_unit_base_address, ranges);
+		/* always record compilation units, so that all execution contexts start with a compilation unit die */
+		if (ranges.empty() && tag != DW_TAG_compile_unit)
+			return parent_node;
+		node = builder.index->context_nodes.size();
+		builder.index->context_nodes.push_back((struct ContextNode) { .die_offset = die_offset, .abbrev_offset = abbrev_offset, .tag = tag,
+				.parent = parent_node, .depth = (parent_node == -1) ? 0 : builder.index->context_nodes.at(parent_node).depth + 1, });
+		for (i = 0; i < ranges.size(); i ++)
+			if (ranges.at(i).first < ranges.at(i).second)
+				builder.ranges.push_back((struct IndexBuilder::AddressRange) { .low = ranges.at(i).first, .high = ranges.at(i).second, .node = node, });
+		return node;
+	}
+	void recordCallSite(struct IndexBuilder & builder, uint32_t die_offset, uint32_t abbrev_offset)
+	{
+		struct Abbreviation a(debug_abbrev + abbrev_offset);
+		auto x = a.dataForAttribute(DW_AT_low_pc, debug_info + die_offset);
+		builder.current_call_site = -1;
+		if (!x.first)
+			return;
+		builder.current_call_site = builder.index->call_sites.size();
+		builder.index->call_sites.push_back((struct DwarfIndex::CallSite) { .address = DwarfUtil::fetchHighLowPC(x.first, x.second),
+				.die_offset = die_offset, .abbrev_offset = abbrev_offset,
+				.first_parameter = (int) builder.index->call_site_parameters.size(), .parameter_count = 0, });
+	}
+	/* returns the number of the register that holds a call site parameter, or -1 if the parameter
+	 * is not passed in a register */
+	int registerNumberOfCallSiteParameter(uint32_t die_offset, uint32_t abbrev_offset)
+	{
+		struct Abbreviation a(debug_abbrev + abbrev_offset);
+		auto x = a.dataForAttribute(DW_AT_location, debug_info + die_offset);
+		int len;
+		switch (x.first)
+		{
+			case DW_FORM_block1:
+				len = * x.second ++;
+				break;
+			case DW_FORM_block:
+			case DW_FORM_exprloc:
+				len = DwarfUtil::uleb128x(x.second);
+				break;
+			default:
+				return -1;
 		}
+		if (len == 1 && DW_OP_reg0 <= * x.second && * x.second <= DW_OP_reg31)
+			return * x.second - DW_OP_reg0;
+		if (len > 1 && * x.second == DW_OP_regx)
+			return DwarfUtil::uleb128(x.second + 1);
+		return -1;
 	}
+	void recordCallSiteParameter(struct IndexBuilder & builder, uint32_t die_offset, uint32_t abbrev_offset)
+	{
+		if (builder.current_call_site == -1)
+			return;
+		builder.index->call_site_parameters.push_back((struct DwarfIndex::CallSiteParameterEntry) { .die_offset = die_offset, .abbrev_offset = abbrev_offset,
+				.register_number = registerNumberOfCallSiteParameter(die_offset, abbrev_offset), });
+		builder.index->call_sites.at(builder.current_call_site).parameter_count ++;
+	}
+	/* builds the address range table segments from the address ranges collected while reaping the dies */
+	void buildAddressRangeTable(struct IndexBuilder & builder)
+	{
+		std::vector<struct IndexBuilder::AddressRange> & ranges(builder.ranges);
+		const std::vector<struct ContextNode> & nodes(builder.index->context_nodes);
+		std::vector<struct DwarfIndex::ContextSegment> & segments(builder.index->context_segments);
+		std::vector<uint32_t> boundaries;
+		std::vector<int> active;
+		int i, j, next_range = 0;
 
-	void reapDieFingerprints(uint32_t & die_offset, std::map<uint32_t, uint32_t> & abbreviations, int depth = 0)
+		std::sort(ranges.begin(), ranges.end(), [] (const struct IndexBuilder::AddressRange & a, const struct IndexBuilder::AddressRange & b) -> bool { return a.low < b.low; });
+		for (i = 0; i < ranges.size(); i ++)
+			boundaries.push_back(ranges.at(i).low), boundaries.push_back(ranges.at(i).high);
+		std::sort(boundaries.begin(), boundaries.end());
+		boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+		/* sweep the boundaries, keeping track of the ranges active at each boundary - the innermost
+		 * active range is the one of the deepest node; dies are properly nested, so the number of
+		 * active ranges at any time is at most the nesting depth of the dies */
+		for (i = 0; i < boundaries.size(); i ++)
+		{
+			uint32_t boundary = boundaries.at(i);
+			int innermost = -1;
+			for (j = 0; j < active.size();)
+				if (ranges.at(active.at(j)).high <= boundary)
+					active.erase(active.begin() + j);
+				else
+					j ++;
+			while (next_range < ranges.size() && ranges.at(next_range).low == boundary)
+				active.push_back(next_range ++);
+			for (j = 0; j < active.size(); j ++)
+				if (innermost == -1 || nodes.at(ranges.at(active.at(j)).node).depth > nodes.at(innermost).depth)
+					innermost = ranges.at(active.at(j)).node;
+			if (segments.empty() || segments.back().node != innermost)
+				segments.push_back((struct DwarfIndex::ContextSegment) { .start = boundary, .node = innermost, });
+		}
+		std::sort(builder.index->call_sites.begin(), builder.index->call_sites.end(),
+			[] (const struct DwarfIndex::CallSite & a, const struct DwarfIndex::CallSite & b) -> bool { return a.address < b.address; });
+	}
+
+	void reapDieFingerprints(uint32_t & die_offset, struct IndexBuilder & builder, int depth = 0, int parent_node = -1)
 	{
-		stats.total_dies ++;
+		struct DwarfIndex & index(* builder.index);
+		index.total_dies ++;
 		const uint8_t * p = debug_info + die_offset;
 		int len;
 		uint32_t code = DwarfUtil::uleb128(p, & len);
@@ -1316,25 +1784,42 @@ private:
 		 * which is explicitly permitted by the dwarf standard. Handle this at the condition check at the start of the loop */
 		while (code)
 		{
-			auto x = abbreviations.find(code);
-			if (x == abbreviations.end())
+			auto x = builder.abbreviations.find(code);
+			if (x == builder.abbreviations.end())
 				DwarfUtil::panic("abbreviation code not found");
-			struct Abbreviation a(debug_abbrev + x->second);
+			uint32_t abbrev_offset = x->second.abbrev_offset;
+			struct Abbreviation a(debug_abbrev + abbrev_offset);
 			
-			die_fingerprints.push_back((struct DieFingerprint) { .offset = die_offset, .abbrev_offset = x->second});
-			
-			auto attr = a.next_attribute();
-			while (attr.first)
+			index.die_fingerprints.push_back((struct DieFingerprint) { .offset = die_offset, .abbrev_offset = abbrev_offset});
+			int node = parent_node;
+			switch (a.tag())
 			{
-				p += DwarfUtil::skip_form_bytes(attr.second, p);
-				attr = a.next_attribute();
+				case DW_TAG_compile_unit:
+				case DW_TAG_subprogram:
+				case DW_TAG_lexical_block:
+				case DW_TAG_inlined_subroutine:
+					node = recordContextNode(builder, die_offset, abbrev_offset, a.tag(), parent_node);
+					break;
+				case DW_TAG_GNU_call_site:
+					recordCallSite(builder, die_offset, abbrev_offset);
+					break;
+				case DW_TAG_GNU_call_site_parameter:
+					recordCallSiteParameter(builder, die_offset, abbrev_offset);
+					break;
 			}
+			
+			if (x->second.data_size != -1)
+				p += x->second.data_size;
+			else
+				p = skipAttributes(a, p);
 			die_offset = p - debug_info;
 			if (a.has_children())
 			{
-				reapDieFingerprints(die_offset, abbreviations, depth + 1);
+				reapDieFingerprints(die_offset, builder, depth + 1, node);
 				p = debug_info + die_offset;
 			}
+			if (a.tag() == DW_TAG_GNU_call_site)
+				builder.current_call_site = -1;
 			
 			if (depth == 0)
 				return;
@@ -1366,31 +1851,65 @@ public:
 		this->debug_loc = (const uint8_t *) debug_loc;
 		this->debug_loc_len = debug_loc_len;
 
-		last_searched_compilation_unit.data = this->debug_info;
-		last_searched_arange = arange.data;
-		memset(& stats, 0, sizeof stats);
+		resetQueryContext();
 		
-		std::map<uint32_t, uint32_t> abbreviations;
+		struct DwarfIndex * index = new DwarfIndex;
+		struct IndexBuilder builder;
 		uint32_t cu;
+		builder.index = index;
+		builder.current_call_site = -1;
 		for (cu = 0; cu != -1; cu = next_compilation_unit(cu))
 		{
 			auto die_offset = cu + /* skip compilation unit header */ 11;
-			stats.total_compilation_units ++;
-			getAbbreviationsOfCompilationUnit(cu, abbreviations);
-			reapDieFingerprints(die_offset, abbreviations);
+			index->total_compilation_units ++;
+			getAbbreviationsOfCompilationUnit(cu, builder);
+			reapDieFingerprints(die_offset, builder);
 		}
-	}
+		buildAddressRangeTable(builder);
+		this->index.reset(index);
+		/* the index must already be in place here, because reading the line number program headers needs it */
+		buildSourceFileTable(index->source_files);
+	}
+	/* creates a new query context for the same debug information - the debug information index is shared
+	 * with 'other', and is not rebuilt, while the query caches and statistics of the new context start out
+	 * empty; different query contexts can be used concurrently from different threads */
+	DwarfData(const DwarfData & other) : arange(other.debug_aranges), last_searched_compilation_unit(other.debug_info), index(other.index)
+	{
+		debug_aranges = other.debug_aranges;
+		debug_aranges_len = other.debug_aranges_len;
+		debug_info = other.debug_info;
+		debug_info_len = other.debug_info_len;
+		debug_abbrev = other.debug_abbrev;
+		debug_abbrev_len = other.debug_abbrev_len;
+		debug_ranges = other.debug_ranges;
+		debug_ranges_len = other.debug_ranges_len;
+		debug_str = other.debug_str;
+		debug_str_len = other.debug_str_len;
+		debug_line = other.debug_line;
+		debug_line_len = other.debug_line_len;
+		debug_loc = other.debug_loc;
+		debug_loc_len = other.debug_loc_len;
+		resetQueryContext();
+	}
+	const struct QueryStatistics & queryStatistics(void) const { return stats; }
+	const std::vector<struct DebugLine::sourceFileNames> & sourceFiles(void) const { return index->source_files; }
+	unsigned totalDies(void) const { return index->total_dies; }
+	unsigned totalCompilationUnits(void) const { return index->total_compilation_units; }
 	void dumpStats(void)
 	{
-		qDebug() << "total dies in .debug_info:" << stats.total_dies;
-		qDebug() << "total compilation units in .debug_info:" << stats.total_compilation_units;
-		qDebug() << "total dies read:" << stats.dies_read;
-		qDebug() << "compilation unit address range search hits:" << stats.compilation_unit_arange_hits;
-		qDebug() << "compilation unit address range search misses:" << stats.compilation_unit_arange_misses;
-		qDebug() << "compilation unit die search hits:" << stats.compilation_unit_header_hits;
-		qDebug() << "compilation unit die search misses:" << stats.compilation_unit_header_misses;
-		qDebug() << "abbreviation fetch hits:" << stats.abbreviation_hits;
-		qDebug() << "abbreviation fetch misses:" << stats.abbreviation_misses;
+		DwarfLog() << "total dies in .debug_info:" << index->total_dies;
+		DwarfLog() << "total compilation units in .debug_info:" << index->total_compilation_units;
+		DwarfLog() << "total dies read:" << stats.dies_read;
+		DwarfLog() << "compilation unit address range search hits:" << stats.compilation_unit_arange_hits;
+		DwarfLog() << "compilation unit address range search misses:" << stats.compilation_unit_arange_misses;
+		DwarfLog() << "compilation unit die search hits:" << stats.compilation_unit_header_hits;
+		DwarfLog() << "compilation unit die search misses:" << stats.compilation_unit_header_misses;
+		DwarfLog() << "abbreviation fetch hits:" << stats.abbreviation_hits;
+		DwarfLog() << "abbreviation fetch misses:" << stats.abbreviation_misses;
+		DwarfLog() << "program counter context cache hits:" << stats.pc_context_hits;
+		DwarfLog() << "program counter context cache misses:" << stats.pc_context_misses;
+		DwarfLog() << "frame descriptor cache hits:" << stats.frame_descriptor_hits;
+		DwarfLog() << "frame descriptor cache misses:" << stats.frame_descriptor_misses;
 	}
 private:
 	/* returns -1 if the compilation unit is not found */
@@ -1406,7 +1925,7 @@ private:
 		while (h.data - debug_info < debug_info_len)
 			if (h.data - debug_info <= debug_info_offset && debug_info_offset < h.data - debug_info + h.unit_length())
 			{
-				last_searched_compilation_unit.data = (const uint8_t *) & h;
+				last_searched_compilation_unit.data = h.data;
 				return h.data - debug_info;
 			}
 			else h.next();
@@ -1459,64 +1978,37 @@ private:
 			DwarfUtil::panic();
 		return DwarfUtil::fetchHighLowPC(low_pc.first, low_pc.second);
 	}
-	bool isAddressInRange(const struct Die & die, uint32_t address, const struct Die & compilation_unit_die)
-	{
-		struct Abbreviation a(debug_abbrev + die.abbrev_offset);
-		auto range = a.dataForAttribute(DW_AT_ranges, debug_info + die.offset);
-		if (range.first)
-		{
-			auto base_address = compilation_unit_base_address(compilation_unit_die);
-			const uint32_t * range_list = (const uint32_t *) (debug_ranges + DwarfUtil::formConstant(range));
-			while (range_list[0] && range_list[1])
-			{
-				if (range_list[0] == -1)
-					base_address = range_list[1];
-				else if (range_list[0] + base_address <= address && address < range_list[1] + base_address)
-					return true;
-				range_list += 2;
-			}
-		}
-		auto low_pc = a.dataForAttribute(DW_AT_low_pc, debug_info + die.offset);
-		if (low_pc.first)
-		{
-			uint32_t x;
-			auto hi_pc = a.dataForAttribute(DW_AT_high_pc, debug_info + die.offset);
-			if (!hi_pc.first)
-				return false;
-			if (DEBUG_ADDRESS_RANGE_ENABLED) qDebug() << (x = DwarfUtil::fetchHighLowPC(low_pc.first, low_pc.second));
-			if (DEBUG_ADDRESS_RANGE_ENABLED) qDebug() << DwarfUtil::fetchHighLowPC(hi_pc.first, hi_pc.second, x);
-			x = DwarfUtil::fetchHighLowPC(low_pc.first, low_pc.second);
-			return x <= address && address < DwarfUtil::fetchHighLowPC(hi_pc.first, hi_pc.second, x);
-		}
-		return false;
-	}
 public:
-	/*! \todo	the name of this function is misleading, it really reads a sequence of dies on a same die tree level; that
-	 * 		is because of the dwarf die flattenned tree representation */
-	std::vector<struct Die> debug_tree_of_die(uint32_t & die_offset, int depth = 0, int max_depth = -1)
+	/* 'fingerprint' is the index in the die fingerprint table of the last die read, or -1; dies are read in .debug_info
+	 * order, so the fingerprint of the next die read is usually the next one in the table, and need not be searched for */
+	std::vector<struct Die> readDieTree(uint32_t & die_offset, int & fingerprint, int depth, int max_depth)
 	{
 		if (STATS_ENABLED) stats.dies_read ++;
+		const std::vector<struct DieFingerprint> & die_fingerprints(index->die_fingerprints);
 		std::vector<struct Die> dies;
 		const uint8_t * p = debug_info + die_offset;
 		int len;
 		uint32_t code = DwarfUtil::uleb128(p, & len);
-		if (DEBUG_DIE_READ_ENABLED) qDebug() << "at offset " << QString("$%1").arg(p - debug_info, 0, 16);
+		if (DEBUG_DIE_READ_ENABLED) DwarfLog() << "at offset " << HEX(p - debug_info);
 		p += len;
 		/*! \note	some compilers (e.g. IAR) generate abbreviations in .debug_abbrev which specify that a die has
 		 * children, while it actually does not - such a die actually considers a single null die child,
 		 * which is explicitly permitted by the dwarf standard. Handle this at the condition check at the start of the loop */
 		while (code)
 		{
-			auto x = abbreviationOffsetForDieOffset(die_offset);
+			if (fingerprint != -1 && fingerprint + 1 < die_fingerprints.size() && die_fingerprints[fingerprint + 1].offset == die_offset)
+				fingerprint ++;
+			else
+				fingerprint = fingerprintIndexForDieOffset(die_offset);
+			auto x = die_fingerprints[fingerprint].abbrev_offset;
 			struct Abbreviation a(debug_abbrev + x);
 			struct Die die(a.tag(), die_offset, x);
 			
-			std::pair<uint32_t, uint32_t> attr = a.next_attribute();
-			while (attr.first)
-			{
-				p += DwarfUtil::skip_form_bytes(attr.second, p);
-				attr = a.next_attribute();
-			}
+			auto data_size = index->abbreviation_data_sizes.find(x);
+			if (data_size != index->abbreviation_data_sizes.end() && data_size->second != -1)
+				p += data_size->second;
+			else
+				p = skipAttributes(a, p);
 			die_offset = p - debug_info;
 			if (a.has_children())
 			{
@@ -1531,7 +2023,7 @@ public:
 						goto there;
 					}
 				}
-				die.children = debug_tree_of_die(die_offset, depth + 1, max_depth);
+				die.children = readDieTree(die_offset, fingerprint, depth + 1, max_depth);
 there:
 				p = debug_info + die_offset;
 			}
@@ -1540,13 +2032,21 @@ there:
 			if (depth == 0)
 				return dies;
 			code = DwarfUtil::uleb128(p, & len);
-			if (DEBUG_DIE_READ_ENABLED) qDebug() << "at offset " << QString("$%1").arg(p - debug_info, 0, 16);
+			if (DEBUG_DIE_READ_ENABLED) DwarfLog() << "at offset " << HEX(p - debug_info);
 			p += len;
 		}
 		die_offset = p - debug_info;
 
 		return dies;
 	}
+public:
+	/*! \todo	the name of this function is misleading, it really reads a sequence of dies on a same die tree level; that
+	 * 		is because of the dwarf die flattenned tree representation */
+	std::vector<struct Die> debug_tree_of_die(uint32_t & die_offset, int depth = 0, int max_depth = -1)
+	{
+		int fingerprint = -1;
+		return readDieTree(die_offset, fingerprint, depth, max_depth);
+	}
 	struct Die read_die(uint32_t die_offset) { return debug_tree_of_die(die_offset, 0, 1).at(0); }
 	uint32_t next_compilation_unit(uint32_t compilation_unit_offset)
 	{
@@ -1555,6 +2055,8 @@ there:
 			x = -1;
 		return x;
 	}
+	/* returns the offset of the compilation unit containing 'address' in .debug_info, or -1 if not found */
+	uint32_t compilationUnitOffsetForAddress(uint32_t address) { return get_compilation_unit_debug_info_offset_for_address(address); }
 	int compilation_unit_count(void)
 	{
 		int i;
@@ -1564,62 +2066,94 @@ there:
 				DwarfUtil::panic();
 		return i;
 	}
+	/* returns the index of the node of the innermost die in the address range table, that contains 'address',
+	 * or -1 if no die contains 'address'; this is a binary search, that does not read any dies */
+	int contextNodeForAddress(uint32_t address) const
+	{
+		const std::vector<struct DwarfIndex::ContextSegment> & segments(index->context_segments);
+		auto x = std::lower_bound(segments.begin(), segments.end(), address + 1);
+		if (x == segments.begin())
+			return -1;
+		return (-- x)->node;
+	}
+	const struct ContextNode & contextNode(int node) const { return index->context_nodes.at(node); }
+private:
+	/* returns the call site table entry with return address 'address', or null if there is none */
+	const struct DwarfIndex::CallSite * callSiteEntryAtAddress(uint32_t address) const
+	{
+		const std::vector<struct DwarfIndex::CallSite> & call_sites(index->call_sites);
+		auto x = std::lower_bound(call_sites.begin(), call_sites.end(), address);
+		return (x == call_sites.end() || x->address != address) ? 0 : & * x;
+	}
+public:
+	/* returns the node of the outermost non-inlined subprogram among 'node' and its enclosing nodes, or -1 if there is none */
+	int topLevelSubprogramNode(int node) const
+	{
+		int subprogram = -1;
+		for (; node != -1; node = contextNode(node).parent)
+			if (contextNode(node).tag == DW_TAG_subprogram)
+				subprogram = node;
+		return subprogram;
+	}
+	/* returns the node of the innermost inlined subroutine among 'node' and its enclosing nodes, up to the
+	 * enclosing non-inlined subprogram, or -1 if there is none; to walk the whole inlining chain for an address,
+	 * start with the node returned by contextNodeForAddress(), and continue with the parent of each node returned */
+	int inlinedSubroutineNode(int node) const
+	{
+		for (; node != -1 && contextNode(node).tag != DW_TAG_subprogram; node = contextNode(node).parent)
+			if (contextNode(node).tag == DW_TAG_inlined_subroutine)
+				return node;
+		return -1;
+	}
 	std::vector<struct Die> executionContextForAddress(uint32_t address)
 	{
 		std::vector<struct Die> context;
-		auto cu_die_offset = get_compilation_unit_debug_info_offset_for_address(address);
-		if (cu_die_offset == -1)
-			return context;
-		cu_die_offset += /* discard the compilation unit header */ 11;
-		auto compilation_unit_die = debug_tree_of_die(cu_die_offset, 0, 1);
-		int i(0);
-		std::vector<struct Die> * die_list(& compilation_unit_die);
-		while (i < die_list->size())
-			if (isAddressInRange(die_list->at(i), address, compilation_unit_die.at(0)))
-			{
-				uint32_t die_offset(die_list->at(i).offset);
-				die_list->at(i).children = debug_tree_of_die(die_offset, /* read only immediate die children */ 0, 2).at(0).children;
-				context.push_back(die_list->at(i));
-				die_list = & die_list->at(i).children;
-				i = 0;
-			}
-			else
-				i ++;
+		int node;
+		for (node = contextNodeForAddress(address); node != -1; node = contextNode(node).parent)
+		{
+			uint32_t die_offset(contextNode(node).die_offset);
+			context.push_back(contextNode(node).die());
+			context.back().children = debug_tree_of_die(die_offset, /* read only immediate die children */ 0, 2).at(0).children;
+		}
+		std::reverse(context.begin(), context.end());
 		return context;
 	}
-	bool callSiteAtAddress(uint32_t address, struct Die & call_site)
+	bool callSiteAtAddress(uint32_t address, struct Die & call_site) const
 	{
-		auto cu_die_offset = get_compilation_unit_debug_info_offset_for_address(address);
-		if (cu_die_offset == -1)
+		const struct DwarfIndex::CallSite * x = callSiteEntryAtAddress(address);
+		if (!x)
 			return false;
-		cu_die_offset += /* discard the compilation unit header */ 11;
-		auto compilation_unit_die = debug_tree_of_die(cu_die_offset, 0, 1);
-		int i(0);
-		std::vector<struct Die> * die_list(& compilation_unit_die);
-		while (i < die_list->size())
-			if (isAddressInRange(die_list->at(i), address, compilation_unit_die.at(0)))
-			{
-				uint32_t die_offset(die_list->at(i).offset);
-				die_list->at(i).children = debug_tree_of_die(die_offset, /* read only immediate die children */ 0, 2).at(0).children;
-				die_list = & die_list->at(i).children;
-				i = 0;
-			}
-			else
+		call_site = Die(DW_TAG_GNU_call_site, x->die_offset, x->abbrev_offset);
+		return true;
+	}
+	struct CallSiteParameter
+	{
+		/* the DW_TAG_GNU_call_site_parameter die */
+		struct Die	die;
+		/* the register that the parameter is passed in, -1 if the parameter is not passed in a register */
+		int		register_number;
+	};
+	/* returns the parameters of the call site with return address 'address', empty if there is no call site there */
+	std::vector<struct CallSiteParameter> callSiteParametersAtAddress(uint32_t address) const
+	{
+		std::vector<struct CallSiteParameter> parameters;
+		const struct DwarfIndex::CallSite * x = callSiteEntryAtAddress(address);
+		int i;
+		if (x)
+			for (i = x->first_parameter; i < x->first_parameter + x->parameter_count; i ++)
 			{
-				if (die_list->at(i).tag == DW_TAG_GNU_call_site)
-				{
-					Abbreviation a(debug_abbrev + die_list->at(i).abbrev_offset);
-					auto x = a.dataForAttribute(DW_AT_low_pc, debug_info + die_list->at(i).offset);
-					if (x.first && DwarfUtil::fetchHighLowPC(x.first, x.second) == address)
-					{
-						call_site = die_list->at(i);
-						return true;
-					}
-				}
-				i ++;
+				const struct DwarfIndex::CallSiteParameterEntry & p(index->call_site_parameters.at(i));
+				parameters.push_back((struct CallSiteParameter) { .die = Die(DW_TAG_GNU_call_site_parameter, p.die_offset, p.abbrev_offset),
+						.register_number = p.register_number, });
 			}
-
-		return false;
+		return parameters;
+	}
+	/* returns the sforth code for computing the value of a call site parameter in the frame of the caller,
+	 * i.e. the value of its DW_AT_GNU_call_site_value attribute, or an empty string if the value is not known */
+	std::string callSiteParameterValueSforthCode(const struct CallSiteParameter & parameter)
+	{
+		/* the compilation unit die is only needed for location lists, which this attribute cannot be */
+		return locationSforthCode(parameter.die, Die(DW_TAG_compile_unit, 0, 0), -1, DW_AT_GNU_call_site_value);
 	}
 	std::vector<struct Die> inliningChainOfContext(const std::vector<struct Die> & context)
 	{
@@ -1654,7 +2188,7 @@ there:
 		int i;
 		std::string frame_base;
 		for (i = context.size() - 1; i >= 0 && frame_base.empty(); frame_base = locationSforthCode(context.at(i --), context.at(0), -1, DW_AT_frame_base));
-		qDebug() << QString::fromStdString(frame_base);
+		if (DEBUG_LOCATION_ENABLED) DwarfLog() << frame_base;
 		return frame_base;
 	}
 	struct SourceCodeCoordinates sourceCodeCoordinatesForDieOffset(uint32_t die_offset)
@@ -1722,6 +2256,171 @@ there:
 		return s;
 	}
 
+	/* computes the address range of the source code line that contains an address, see 'DebugLine::lineAddressRangeForAddress()';
+	 * returns false if there is no line number information for the address */
+	bool lineAddressRangeForAddress(uint32_t address, uint32_t & start_address, uint32_t & end_address)
+	{
+		auto cu_die_offset = get_compilation_unit_debug_info_offset_for_address(address);
+		if (cu_die_offset == -1)
+			return false;
+		cu_die_offset += /* skip compilation unit header */ 11;
+
+		auto compilation_unit_die = read_die(cu_die_offset);
+		if (compilation_unit_die.tag != DW_TAG_compile_unit)
+			DwarfUtil::panic();
+		Abbreviation a(debug_abbrev + compilation_unit_die.abbrev_offset);
+		auto x = a.dataForAttribute(DW_AT_stmt_list, debug_info + compilation_unit_die.offset);
+		if (!x.first)
+			return false;
+		class DebugLine l(debug_line, debug_line_len);
+		return l.lineAddressRangeForAddress(DwarfUtil::formConstant(x), address, start_address, end_address);
+	}
+
+	/* the execution context data for a program counter value - all that is needed to display a frame */
+	struct ProgramCounterContext
+	{
+		uint32_t			pc;
+		std::vector<struct Die>		context;
+		std::string			frame_base_sforth_code;
+		struct SourceCodeCoordinates	coordinates;
+		bool				is_address_on_exact_line_number_boundary;
+	};
+	/* returns the execution context data for a program counter value; the data for the most recently used
+	 * program counter values is cached, so that halting again at the same address (e.g. at the same breakpoint,
+	 * or in the same idle loop) needs no dwarf parsing at all; the returned reference is only valid until
+	 * the next call of this function */
+	const struct ProgramCounterContext & programCounterContext(uint32_t pc)
+	{
+		auto x = pc_contexts.find(pc);
+		if (x != pc_contexts.end())
+		{
+			if (STATS_ENABLED) stats.pc_context_hits ++;
+			pc_context_lru.splice(pc_context_lru.begin(), pc_context_lru, x->second);
+			return * x->second;
+		}
+		if (STATS_ENABLED) stats.pc_context_misses ++;
+		if (pc_context_lru.size() >= PC_CONTEXT_CACHE_SIZE)
+			pc_contexts.erase(pc_context_lru.back().pc), pc_context_lru.pop_back();
+		struct ProgramCounterContext c;
+		c.pc = pc;
+		c.context = executionContextForAddress(pc);
+		c.frame_base_sforth_code = sforthCodeFrameBaseForContext(c.context);
+		c.coordinates = sourceCodeCoordinatesForAddress(pc, & c.is_address_on_exact_line_number_boundary);
+		pc_context_lru.push_front(std::move(c));
+		pc_contexts[pc] = pc_context_lru.begin();
+		return pc_context_lru.front();
+	}
+private:
+	/* the program counter context cache - most recently used entries first */
+	std::list<struct ProgramCounterContext> pc_context_lru;
+	std::unordered_map<uint32_t, std::list<struct ProgramCounterContext>::iterator> pc_contexts;
+public:
+
+	struct SymbolizedAddress
+	{
+		struct SourceCodeCoordinates	coordinates;
+		/* the top-level (i.e. non-inlined) subprogram, that contains the address; if
+		 * no such subprogram is found, the offset of this die is zero */
+		struct Die			subprogram;
+		const char			* subprogram_name;
+		/* the inlined subroutines, that contain the address, innermost first */
+		std::vector<struct Die>		inlining_chain;
+		SymbolizedAddress(void) { subprogram_name = "<<< unknown >>>"; }
+	};
+	/* symbolizes a whole batch of addresses at once; the returned vector contains the results in the same order as the
+	 * input addresses; the addresses are sorted internally, and grouped by compilation unit, so that the line number
+	 * program of each compilation unit is run only once, regardless of the number of addresses in the compilation unit */
+	std::vector<struct SymbolizedAddress> sourceCodeCoordinatesForAddresses(const std::vector<uint32_t> & addresses)
+	{
+		std::vector<struct SymbolizedAddress> results(addresses.size());
+		/* first number is the address, the second is the index of the address in the input vector */
+		std::vector<std::pair<uint32_t, uint32_t> > sorted_addresses;
+		/* the keys are compilation unit offsets, the values are indices in 'sorted_addresses' */
+		std::map<uint32_t, std::vector<uint32_t> > compilation_units;
+		int i;
+
+		sorted_addresses.reserve(addresses.size());
+		for (i = 0; i < addresses.size(); i ++)
+			sorted_addresses.push_back(std::pair<uint32_t, uint32_t>(addresses.at(i), i)), results.at(i).coordinates.address = addresses.at(i);
+		std::sort(sorted_addresses.begin(), sorted_addresses.end());
+		for (i = 0; i < sorted_addresses.size(); i ++)
+		{
+			auto cu = get_compilation_unit_debug_info_offset_for_address(sorted_addresses.at(i).first);
+			if (cu != -1)
+				compilation_units[cu].push_back(i);
+		}
+
+		class DebugLine l(debug_line, debug_line_len);
+		std::vector<uint32_t> cu_addresses;
+		std::vector<struct DebugLine::lineNumber> line_numbers;
+		for (auto cu = compilation_units.begin(); cu != compilation_units.end(); cu ++)
+		{
+			auto compilation_unit_die = read_die(cu->first + /* skip compilation unit header */ 11);
+			if (compilation_unit_die.tag != DW_TAG_compile_unit)
+				DwarfUtil::panic();
+			const std::vector<uint32_t> & indices(cu->second);
+			Abbreviation a(debug_abbrev + compilation_unit_die.abbrev_offset);
+			const char * compilation_directory_name = SourceCodeCoordinates().compilation_directory_name;
+			auto x = a.dataForAttribute(DW_AT_comp_dir, debug_info + compilation_unit_die.offset);
+			if (x.first)
+				compilation_directory_name = DwarfUtil::formString(x.first, x.second, debug_str);
+
+			x = a.dataForAttribute(DW_AT_stmt_list, debug_info + compilation_unit_die.offset);
+			if (x.first)
+			{
+				cu_addresses.clear();
+				for (i = 0; i < indices.size(); i ++)
+					cu_addresses.push_back(sorted_addresses.at(indices.at(i)).first);
+				line_numbers.resize(cu_addresses.size());
+				l.lineNumbersForAddresses(DwarfUtil::formConstant(x), cu_addresses.data(), cu_addresses.size(), line_numbers.data());
+				/* cache the file and directory names - looking them up requires a linear scan of the file name table */
+				std::map<uint32_t, std::pair<const char *, const char *> > file_names;
+				for (i = 0; i < indices.size(); i ++)
+				{
+					struct SourceCodeCoordinates & s(results.at(sorted_addresses.at(indices.at(i)).second).coordinates);
+					auto f = file_names.find(line_numbers.at(i).file);
+					if (f == file_names.end())
+					{
+						std::pair<const char *, const char *> names;
+						l.stringsForFileNumber(line_numbers.at(i).file, names.first, names.second, compilation_directory_name);
+						f = file_names.insert(std::pair<uint32_t, std::pair<const char *, const char *> >(line_numbers.at(i).file, names)).first;
+					}
+					s.line = line_numbers.at(i).line;
+					s.file_name = f->second.first;
+					s.directory_name = f->second.second;
+					s.compilation_directory_name = compilation_directory_name;
+				}
+			}
+
+			/* the addresses are sorted, so successive addresses usually have the same innermost context */
+			std::vector<struct Die> inlining_chain;
+			struct Die subprogram;
+			const char * subprogram_name = SymbolizedAddress().subprogram_name;
+			int node, last_node = -1;
+			for (i = 0; i < indices.size(); i ++)
+			{
+				struct SymbolizedAddress & s(results.at(sorted_addresses.at(indices.at(i)).second));
+				if ((node = contextNodeForAddress(s.coordinates.address)) == -1)
+					continue;
+				if (node != last_node)
+				{
+					int n;
+					last_node = node;
+					inlining_chain.clear();
+					for (n = inlinedSubroutineNode(node); n != -1; n = inlinedSubroutineNode(contextNode(n).parent))
+						inlining_chain.push_back(contextNode(n).die());
+					subprogram = Die(), subprogram_name = SymbolizedAddress().subprogram_name;
+					if ((n = topLevelSubprogramNode(node)) != -1)
+						subprogram = contextNode(n).die(), subprogram_name = nameOfDie(subprogram);
+				}
+				s.subprogram = subprogram;
+				s.subprogram_name = subprogram_name;
+				s.inlining_chain = inlining_chain;
+			}
+		}
+		return results;
+	}
+
 private:
 	uint32_t readTypeOffset(uint32_t attribute_form, const uint8_t * debug_info_bytes, uint32_t compilation_unit_header_offset)
 	{
@@ -1759,7 +2458,6 @@ private:
 		}
 		return true;
 	}
-std::map<uint32_t, uint32_t> recursion_detector;
 public:
 int readType(uint32_t die_offset, std::vector<struct DwarfTypeNode> & type_cache, bool reset_recursion_detector = true);
 bool isPointerType(const std::vector<struct DwarfTypeNode> & type, int node_number = 0);
@@ -1825,7 +2523,7 @@ if (is_prefix_printed)
 				Abbreviation a(debug_abbrev + die.abbrev_offset);
 				auto x = a.dataForAttribute(DW_AT_bit_size, debug_info + die.offset);
 				if (x.first)
-					type_string += QString(" : %1").arg(DwarfUtil::formConstant(x)).toStdString();
+					type_string += " : " + std::to_string(DwarfUtil::formConstant(x));
 			}
 				break;
 			case DW_TAG_volatile_type:
@@ -1876,7 +2574,7 @@ if (is_prefix_printed)
 				switch (DwarfUtil::formConstant(x))
 				{
 					default:
-						qDebug() << "unhandled encoding" << DwarfUtil::formConstant(x);
+						DwarfLog() << "unhandled encoding" << DwarfUtil::formConstant(x);
 						DwarfUtil::panic();
 					case DW_ATE_UTF:
 						type_string += "utf ";
@@ -1980,8 +2678,8 @@ if (is_prefix_printed)
 				type_string += typeChainString(type, is_prefix_printed, short_type_print, type.at(node_number).next);
 				break;
 			default:
-				qDebug() << "unhandled tag" <<  type.at(node_number).die.tag << "in" << __func__;
-				qDebug() << "die offset" << type.at(node_number).die.offset;
+				DwarfLog() << "unhandled tag" <<  type.at(node_number).die.tag << "in" << __func__;
+				DwarfLog() << "die offset" << type.at(node_number).die.offset;
 				DwarfUtil::panic();
 		}
 		return type_string;
@@ -1993,7 +2691,7 @@ if (is_prefix_printed)
 		if (node_number == -1)
 		{
 		/*! \todo	handle declarations here - for some reason they appear here */
-			qDebug() << __func__ << "bad node index";
+			DwarfLog() << __func__ << "bad node index";
 			return -1;
 			DwarfUtil::panic();
 		}
@@ -2048,8 +2746,8 @@ if (is_prefix_printed)
 		
 		if (1 && type.at(type_node_number).processed)
 		{
-			qDebug() << "recursion detected in" << __func__;
-			qDebug() << "node index" << type_node_number;
+			DwarfLog() << "recursion detected in" << __func__;
+			DwarfLog() << "node index" << type_node_number;
 node.data.push_back("!!! recursion detected !!!");
 			return;
 		}
@@ -2125,7 +2823,7 @@ node.data.push_back("!!! recursion detected !!!");
 			case DW_TAG_subprogram:
 				break;
 			default:
-				qDebug() << "unhandled tag" << type.at(type_node_number).die.tag << "in" << __func__;
+				DwarfLog() << "unhandled tag" << type.at(type_node_number).die.tag << "in" << __func__;
 				DwarfUtil::panic();
 		}
 		type.at(type_node_number).processed = false;
@@ -2208,15 +2906,15 @@ node.data.push_back("!!! recursion detected !!!");
 	{
 		auto addresses = unfilteredAddressesForFileAndLineNumber(filename, line_number);
 		std::vector<uint32_t> filtered_addresses;
-		std::map<uint32_t /* context die offset */, int> contexts;
+		std::map<int /* context node */, int> contexts;
 		int i;
 		for (i = 0; i < addresses.size(); i ++)
 		{
-			auto x = executionContextForAddress(addresses.at(i));
-			if (!x.size())
+			auto x = contextNodeForAddress(addresses.at(i));
+			if (x == -1)
 				filtered_addresses.push_back(addresses.at(i));
-			else if (contexts.find(x.back().offset) == contexts.end())
-				contexts.operator [](x.back().offset) = 1, filtered_addresses.push_back(addresses.at(i));
+			else if (contexts.find(x) == contexts.end())
+				contexts.operator [](x) = 1, filtered_addresses.push_back(addresses.at(i));
 		}
 		return filtered_addresses;
 	}
@@ -2256,8 +2954,39 @@ node.data.push_back("!!! recursion detected !!!");
 			l.getFileAndDirectoryNamesPointers(sources, compilation_directory);
 		}
 	}
-
 private:
+	/* the directory names may be null, if a compilation unit does not have a DW_AT_comp_dir attribute */
+	struct SourceFileNamesHash
+	{
+		size_t operator () (const struct DebugLine::sourceFileNames & x) const
+		{
+			const char * s;
+			size_t h = 2166136261u;
+			for (s = x.file; s && * s; h = (h ^ (uint8_t) * s ++) * 16777619u);
+			h = (h ^ '/') * 16777619u;
+			for (s = x.directory; s && * s; h = (h ^ (uint8_t) * s ++) * 16777619u);
+			return h;
+		}
+	};
+	struct SourceFileNamesEqual
+	{
+		bool operator () (const struct DebugLine::sourceFileNames & a, const struct DebugLine::sourceFileNames & b) const
+		{ return !strcmp(a.file, b.file) && !strcmp(a.directory ? a.directory : "", b.directory ? b.directory : ""); }
+	};
+	void buildSourceFileTable(std::vector<struct DebugLine::sourceFileNames> & source_files)
+	{
+		std::vector<struct DebugLine::sourceFileNames> sources;
+		std::unordered_set<struct DebugLine::sourceFileNames, struct SourceFileNamesHash, struct SourceFileNamesEqual> unique_sources;
+		int i;
+		getFileAndDirectoryNamesPointers(sources);
+		unique_sources.reserve(sources.size());
+		for (i = 0; i < sources.size(); i ++)
+			if (unique_sources.insert(sources.at(i)).second)
+				source_files.push_back(sources.at(i));
+		std::sort(source_files.begin(), source_files.end(), [] (const struct DebugLine::sourceFileNames & a, const struct DebugLine::sourceFileNames & b) -> bool
+			{ int x = strcmp(a.file, b.file); return x ? x < 0 : strcmp(a.directory ? a.directory : "", b.directory ? b.directory : "") < 0; });
+	}
+
 	void fillStaticObjectDetails(const struct Die & die, struct StaticObject & x)
 	{
 		struct Die referred_die(die);
@@ -2342,7 +3071,7 @@ public:
 		auto x(a.dataForAttribute(location_attribute, debug_info + die.offset));
 		if (!x.first)
 			return "";
-		qDebug() << "processing die offset" << die.offset;
+		if (DEBUG_LOCATION_ENABLED) DwarfLog() << "processing die offset" << die.offset;
 		if (location_attribute == DW_AT_const_value)
 		{
 			std::stringstream result;
@@ -2366,7 +3095,7 @@ public:
 			}
 			case DW_FORM_data4:
 			case DW_FORM_sec_offset:
-			qDebug() << "location list offset:" << * (uint32_t *) x.second;
+			if (DEBUG_LOCATION_ENABLED) DwarfLog() << "location list offset:" << * (uint32_t *) x.second;
 				auto l = LocationList::locationExpressionForAddress(debug_loc, * (uint32_t *) x.second,
 					compilation_unit_base_address(compilation_unit_die), address_for_location);
 				return l ? DwarfExpression::sforthCode(l + 2, * (uint16_t *) l) : "";
@@ -2376,9 +3105,152 @@ public:
 
 		DwarfUtil::panic();
 	}
+
+	/* a local data object of a subprogram, with everything needed to display it, except for its value,
+	 * precompiled - so that refreshing the local data objects view after a step only takes reading target memory */
+	struct FrameLocal
+	{
+		struct Die		die;
+		std::string		name;
+		/* the size, and the layout of the type of the data object */
+		int			size;
+		struct DataNode		data;
+		/* if the location of the data object is a location list, the location depends on the program counter
+		 * value, and the compiled location list entries are searched; otherwise, the location is the same in
+		 * the whole scope of the data object */
+		bool			has_location_list;
+		std::string		location_sforth_code;
+		struct LocationListEntry { uint32_t low_pc, high_pc; std::string sforth_code; };
+		std::vector<struct LocationListEntry> location_list;
+		/* nonempty if the data object has been evaluated as a compile-time constant */
+		std::string		const_value_sforth_code;
+		std::string locationSforthCode(uint32_t pc) const
+		{
+			int i;
+			if (!has_location_list)
+				return location_sforth_code;
+			for (i = 0; i < location_list.size(); i ++)
+				if (location_list.at(i).low_pc <= pc && pc < location_list.at(i).high_pc)
+					return location_list.at(i).sforth_code;
+			return "";
+		}
+	};
+	/* the local data objects of a (non-inlined) subprogram, including the ones of all lexical blocks
+	 * and inlined subroutines in it */
+	struct FrameDescriptor
+	{
+		uint32_t			subprogram_offset;
+		std::vector<struct FrameLocal>	locals;
+		/* indices in 'locals', keyed by the die offset of the scope (a subprogram, an inlined subroutine,
+		 * or a lexical block) which owns the data objects */
+		std::unordered_map<uint32_t, std::vector<int> >	scopes;
+	};
+	/* returns the frame descriptor for the non-inlined subprogram of an execution context; the descriptor
+	 * is built when a subprogram is first entered, and is cached afterwards; if the context is empty, or
+	 * has no non-inlined subprogram, an empty descriptor is returned */
+	const struct FrameDescriptor & frameDescriptorForContext(const std::vector<struct Die> & context)
+	{
+		static const struct FrameDescriptor empty_frame_descriptor {};
+		int i;
+		for (i = 0; i < context.size() && !context.at(i).isNonInlinedSubprogram(); i ++)
+			;
+		if (i == context.size())
+			return empty_frame_descriptor;
+		auto subprogram = context.at(i);
+		auto x = frame_descriptors.find(subprogram.offset);
+		if (x != frame_descriptors.end())
+		{
+			if (STATS_ENABLED) stats.frame_descriptor_hits ++;
+			return x->second;
+		}
+		if (STATS_ENABLED) stats.frame_descriptor_misses ++;
+		struct FrameDescriptor & frame(frame_descriptors[subprogram.offset]);
+		frame.subprogram_offset = subprogram.offset;
+		uint32_t die_offset = subprogram.offset;
+		auto dies = debug_tree_of_die(die_offset);
+		reapFrameLocals(frame, dies.at(0), context.at(0));
+		return frame;
+	}
+	/* returns the local data objects, visible in an execution context - the innermost scope data objects
+	 * first, in the same order as 'localDataObjectsForContext()' */
+	std::vector<const struct FrameLocal *> frameLocalsForContext(const struct FrameDescriptor & frame, const std::vector<struct Die> & context)
+	{
+		std::vector<const struct FrameLocal *> locals;
+		int i, j;
+		for (i = context.size() - 1; i >= 0; i --)
+			if (context.at(i).isSubprogram() || context.at(i).isLexicalBlock())
+			{
+				auto x = frame.scopes.find(context.at(i).offset);
+				if (x != frame.scopes.end())
+					for (j = 0; j < x->second.size(); j ++)
+						locals.push_back(& frame.locals.at(x->second.at(j)));
+			}
+		return locals;
+	}
+private:
+	/* the frame descriptor cache, keyed by subprogram die offsets */
+	std::unordered_map<uint32_t, struct FrameDescriptor> frame_descriptors;
+	void reapFrameLocals(struct FrameDescriptor & frame, const struct Die & die, const struct Die & compilation_unit_die)
+	{
+		int i;
+		bool is_scope = die.isSubprogram() || die.isLexicalBlock();
+		for (i = 0; i < die.children.size(); i ++)
+		{
+			const struct Die & child(die.children.at(i));
+			if (is_scope && child.isDataObject())
+			{
+				frame.scopes[die.offset].push_back(frame.locals.size());
+				frame.locals.push_back(frameLocal(child, compilation_unit_die));
+			}
+			else if (child.children.size())
+				reapFrameLocals(frame, child, compilation_unit_die);
+		}
+	}
+	struct FrameLocal frameLocal(const struct Die & die, const struct Die & compilation_unit_die)
+	{
+		struct FrameLocal local;
+		std::vector<struct DwarfTypeNode> type_cache;
+		local.die = die;
+		local.name = nameOfDie(die);
+		readType(die.offset, type_cache);
+		local.size = sizeOf(type_cache);
+		local.data.bytesize = 0;
+		local.const_value_sforth_code = locationSforthCode(die, compilation_unit_die, -1, DW_AT_const_value);
+		local.has_location_list = false;
+
+		Abbreviation a(debug_abbrev + die.abbrev_offset);
+		auto x(a.dataForAttribute(DW_AT_location, debug_info + die.offset));
+		if (x.first == DW_FORM_data4 || x.first == DW_FORM_sec_offset)
+		{
+			local.has_location_list = true;
+			uint32_t base_address = compilation_unit_base_address(compilation_unit_die);
+			const uint32_t * p((const uint32_t *)(debug_loc + * (uint32_t *) x.second));
+			while (* p || p[1])
+			{
+				if (* p == 0xffffffff)
+				{
+					base_address = 1[p], p += 2;
+					continue;
+				}
+				const uint8_t * expression = (const uint8_t *) (p + 2);
+				struct FrameLocal::LocationListEntry entry = { p[0] + base_address, p[1] + base_address,
+					DwarfExpression::sforthCode(expression + 2, * (uint16_t *) expression), };
+				local.location_list.push_back(entry);
+				p = (const uint32_t *)(expression + * (uint16_t *) expression + 2);
+			}
+		}
+		else
+			local.location_sforth_code = locationSforthCode(die, compilation_unit_die);
+		/* only lay out the types of data objects which can actually be displayed */
+		if ((local.has_location_list || !local.location_sforth_code.empty()) && type_cache.size() > 1)
+			dataForType(type_cache, local.data, true, 1);
+		return local;
+	}
+public:
 	void runTests(void)
 	{
 		int i, test_count = 0;
+		const std::vector<struct DieFingerprint> & die_fingerprints(index->die_fingerprints);
 		for (i = 0; i < die_fingerprints.size(); i ++)
 		{
 			Abbreviation a(debug_abbrev + die_fingerprints[i].abbrev_offset);
@@ -2403,7 +3275,7 @@ public:
 				case DW_FORM_data4:
 				case DW_FORM_sec_offset:
 				{
-if (DWARF_EXPRESSION_TESTS_DEBUG_ENABLED) qDebug() << "location list at offset" << QString("$%1").arg(* (uint32_t *) x.second, 0, 16);
+if (DWARF_EXPRESSION_TESTS_DEBUG_ENABLED) DwarfLog() << "location list at offset" << HEX(* (uint32_t *) x.second);
 					const uint32_t * p((const uint32_t *)(debug_loc + * (uint32_t *) x.second));
 					while (* p || p[1])
 					{
@@ -2415,7 +3287,7 @@ if (DWARF_EXPRESSION_TESTS_DEBUG_ENABLED) qDebug() << "location list at offset"
 				}
 			}
 		}
-		qDebug() << "executed dwarf expression decoding tests, total tests executed:" << test_count;
+		DwarfLog() << "executed dwarf expression decoding tests, total tests executed:" << test_count;
 	}
 };
 
@@ -2568,24 +3440,25 @@ private:
 
 		void dump(void)
 		{
-			if (UNWIND_DEBUG_ENABLED) qDebug() << (isCIE() ? "CIE" : "FDE");
+			if (UNWIND_DEBUG_ENABLED) DwarfLog() << (isCIE() ? "CIE" : "FDE");
 			if (isCIE())
 			{
-				if (UNWIND_DEBUG_ENABLED) qDebug() << "version " << version();
-				if (UNWIND_DEBUG_ENABLED) qDebug() << "code alignment factor " << code_alignment_factor();
-				if (UNWIND_DEBUG_ENABLED) qDebug() << "data alignment factor " << data_alignment_factor();
-				if (UNWIND_DEBUG_ENABLED) qDebug() << "return address register " << return_address_register();
+				if (UNWIND_DEBUG_ENABLED) DwarfLog() << "version " << version();
+				if (UNWIND_DEBUG_ENABLED) DwarfLog() << "code alignment factor " << code_alignment_factor();
+				if (UNWIND_DEBUG_ENABLED) DwarfLog() << "data alignment factor " << data_alignment_factor();
+				if (UNWIND_DEBUG_ENABLED) DwarfLog() << "return address register " << return_address_register();
 				auto insn = initial_instructions();
-				//qDebug() << "initial instructions " << QByteArray((const char *) insn.first, insn.second).toHex() << "count" << insn.second;
-				if (UNWIND_DEBUG_ENABLED) qDebug() << "initial instructions " << QString().fromStdString(ciefde_sforth_code());
+				//DwarfLog() << "initial instructions " << QByteArray((const char *) insn.first, insn.second).toHex() << "count" << insn.second;
+				if (UNWIND_DEBUG_ENABLED) DwarfLog() << "initial instructions " << ciefde_sforth_code();
 			}
 			else
 			{
-				if (UNWIND_DEBUG_ENABLED) qDebug() << "initial address " << QString("$%1").arg(initial_location(), 0, 16);
-				if (UNWIND_DEBUG_ENABLED) qDebug() << "range " << address_range();
-				if (UNWIND_DEBUG_ENABLED) qDebug() << "instructions " << QString().fromStdString(ciefde_sforth_code());
+				if (UNWIND_DEBUG_ENABLED) DwarfLog() << "initial address " << HEX(initial_location());
+				if (UNWIND_DEBUG_ENABLED) DwarfLog() << "range " << address_range();
+				if (UNWIND_DEBUG_ENABLED) DwarfLog() << "instructions " << ciefde_sforth_code();
 			}
 		}
+		uint32_t offset(void) { return data - debug_frame; }
 		void next(void) { if (data != debug_frame + debug_frame_len) data += sizeof(uint32_t) + length(); }
 		bool atEnd(void) { return (data == debug_frame + debug_frame_len) ? true : false; }
 		void rewind(void) { data = debug_frame; }
@@ -2603,17 +3476,50 @@ private:
 	};
 	
 	struct CIEFDE ciefde;
+	/* the frame description entries, sorted by initial location (and by offset, for the same initial location), for fast
+	 * lookups by address; 'max_end' is the highest end address of this and all preceding entries, so that a lookup can
+	 * stop searching backwards for enclosing entries as soon as no preceding entry can contain the address */
+	struct FdeIndexEntry
+	{
+		uint32_t	initial_location, address_range, offset, max_end;
+		bool operator < (const struct FdeIndexEntry & rhs) const
+		{ return initial_location < rhs.initial_location || (initial_location == rhs.initial_location && offset < rhs.offset); }
+	};
+	std::vector<struct FdeIndexEntry> fde_index;
 
 public:
-	DwarfUnwinder(const void * debug_frame, uint32_t debug_frame_len) : ciefde((const uint8_t *) debug_frame, debug_frame_len, 0) { this->debug_frame = (const uint8_t *) debug_frame, this->debug_frame_len = debug_frame_len; }
+	DwarfUnwinder(const void * debug_frame, uint32_t debug_frame_len) : ciefde((const uint8_t *) debug_frame, debug_frame_len, 0)
+	{
+		this->debug_frame = (const uint8_t *) debug_frame, this->debug_frame_len = debug_frame_len;
+		CIEFDE x(this->debug_frame, debug_frame_len, 0);
+		for (x.rewind(); !x.atEnd(); x.next())
+			if (x.isFDE())
+				fde_index.push_back((struct FdeIndexEntry) { x.initial_location(), x.address_range(), (uint32_t) (x.offset()), 0, });
+		std::sort(fde_index.begin(), fde_index.end());
+		uint32_t max_end = 0;
+		for (auto & fde : fde_index)
+			fde.max_end = max_end = std::max(max_end, fde.initial_location + fde.address_range);
+	}
 	void dump(void) { ciefde.dump(); }
 	void next(void) { ciefde.next(); }
 	bool at_end(void) { return ciefde.atEnd(); }
 	void rewind(void) { ciefde.rewind(); }
+	/* returns the offset in the .debug_frame section of the frame description entry for 'address', or -1 if not found */
+	uint32_t fdeOffsetForAddress(uint32_t address) const
+	{
+		/* return the same entry as 'CIEFDE::fdeForAddress()' - i.e., the first one in the .debug_frame section that
+		 * contains the address; there may be several, e.g. entries of discarded code are usually left at address 0 */
+		auto x = std::upper_bound(fde_index.begin(), fde_index.end(), (struct FdeIndexEntry) { address, 0, (uint32_t) -1, 0, });
+		uint32_t fde_offset = -1;
+		while (x != fde_index.begin() && address < (-- x)->max_end)
+			if (address < x->initial_location + x->address_range && x->offset < fde_offset)
+				fde_offset = x->offset;
+		return fde_offset;
+	}
 	/* the string in the pair is the sforth dwarf unwind code, the integer is the base address for the unwind code */
 	std::pair<std::string, uint32_t> sforthCodeForAddress(uint32_t address)
 	{
-		uint32_t fde_offset(ciefde.fdeForAddress(address));
+		uint32_t fde_offset(fdeOffsetForAddress(address));
 		if (fde_offset == -1) 
 			return std::pair<std::string, uint32_t>("abort", -1);
 		CIEFDE fde(debug_frame, debug_frame_len, fde_offset), cie(debug_frame, debug_frame_len, fde.CIE_pointer());
@@ -0,0 +1,14 @@
+# the troll dwarf engine, built as a standalone static library - it only depends on the c++ standard library;
+# libtroll diagnostic messages can be compiled out by adding 'DEFINES += LIBTROLL_LOG_ENABLED=0'
+
+TEMPLATE = lib
+CONFIG += staticlib c++11
+CONFIG -= qt
+TARGET = troll
+
+SOURCES += \
+    libtroll.cxx
+
+HEADERS += \
+    dwarf.h \
+    libtroll.hxx
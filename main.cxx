@@ -21,9 +21,17 @@ THE SOFTWARE.
 */
 #include "troll.hxx"
 #include <QApplication>
+#include <QDebug>
+
+/* route the libtroll diagnostic messages to the qt message handler */
+static void libtrollMessage(const char * message)
+{
+	qDebug().noquote() << message;
+}
 
 int main(int argc, char *argv[])
 {
+	DwarfLog::setSink(libtrollMessage);
 	QApplication a(argc, argv);
 	MainWindow w;
 	w.show();
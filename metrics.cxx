@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#include "metrics.hxx"
+#include <QJsonArray>
+
+Metrics::Histogram::Histogram(void) : sample_count(0), sum(0), minimum(UINT64_MAX), maximum(0)
+{
+	for (auto & b : buckets)
+		b = 0;
+}
+
+void Metrics::Histogram::record(uint64_t microseconds)
+{
+int bucket;
+	for (bucket = 0; bucket < BUCKET_COUNT - 1 && microseconds > bucketUpperBound(bucket); bucket ++)
+		;
+	buckets[bucket] ++;
+	sample_count ++;
+	sum += microseconds;
+	uint64_t x = minimum;
+	while (microseconds < x && !minimum.compare_exchange_weak(x, microseconds))
+		;
+	x = maximum;
+	while (microseconds > x && !maximum.compare_exchange_weak(x, microseconds))
+		;
+}
+
+uint64_t Metrics::Histogram::percentile(double p) const
+{
+uint64_t n = sample_count, rank, seen;
+int i;
+	if (!n)
+		return 0;
+	rank = (uint64_t) (p / 100. * n + .5);
+	if (rank < 1)
+		rank = 1;
+	for (seen = i = 0; i < BUCKET_COUNT; i ++)
+		if ((seen += buckets[i]) >= rank)
+			break;
+	if (i == BUCKET_COUNT)
+		i --;
+	uint64_t x = bucketUpperBound(i), m = maximum;
+	return x < m ? x : m;
+}
+
+QJsonObject Metrics::Histogram::toJson(void) const
+{
+QJsonObject h;
+QJsonArray b;
+int i;
+	h["count"] = (double) count();
+	h["sum_us"] = (double) total();
+	h["min_us"] = (double) min();
+	h["max_us"] = (double) max();
+	h["mean_us"] = mean();
+	h["p50_us"] = (double) percentile(50);
+	h["p90_us"] = (double) percentile(90);
+	h["p99_us"] = (double) percentile(99);
+	/* only the nonempty buckets are exported, as [upper bound, sample count] pairs; the upper bound of the last bucket is -1 */
+	for (i = 0; i < BUCKET_COUNT; i ++)
+		if (buckets[i])
+			b.append(QJsonArray() << (i == BUCKET_COUNT - 1 ? -1. : (double) bucketUpperBound(i)) << (double) buckets[i]);
+	h["buckets"] = b;
+	return h;
+}
+
+Metrics::Registry & Metrics::registry(void)
+{
+	/* intentionally leaked, so that metrics can be updated until the very end of the program */
+	static struct Registry * r = new Registry;
+	return * r;
+}
+
+Metrics::Counter & Metrics::counter(const QString &name)
+{
+struct Registry & r(registry());
+QMutexLocker lock(& r.mutex);
+	auto & x = r.counters[name];
+	if (!x)
+		x.reset(new Counter);
+	return * x;
+}
+
+Metrics::Gauge & Metrics::gauge(const QString &name)
+{
+struct Registry & r(registry());
+QMutexLocker lock(& r.mutex);
+	auto & x = r.gauges[name];
+	if (!x)
+		x.reset(new Gauge);
+	return * x;
+}
+
+Metrics::Histogram & Metrics::histogram(const QString &name)
+{
+struct Registry & r(registry());
+QMutexLocker lock(& r.mutex);
+	auto & x = r.histograms[name];
+	if (!x)
+		x.reset(new Histogram);
+	return * x;
+}
+
+void Metrics::addCollector(std::function<void ()> collector)
+{
+struct Registry & r(registry());
+QMutexLocker lock(& r.mutex);
+	r.collectors.push_back(collector);
+}
+
+void Metrics::runCollectors(void)
+{
+std::vector<std::function<void(void)>> collectors;
+	{
+		struct Registry & r(registry());
+		QMutexLocker lock(& r.mutex);
+		collectors = r.collectors;
+	}
+	/* the collectors update metrics, so they must be run with the registry unlocked */
+	for (auto & c : collectors)
+		c();
+}
+
+QVector<Metrics::Snapshot> Metrics::snapshot(void)
+{
+std::map<QString, QString> values;
+QVector<struct Snapshot> result;
+	runCollectors();
+	struct Registry & r(registry());
+	QMutexLocker lock(& r.mutex);
+	for (auto & c : r.counters)
+		values[c.first] = QString::number(c.second->value());
+	for (auto & g : r.gauges)
+		values[g.first] = QString::number(g.second->value());
+	for (auto & h : r.histograms)
+		values[h.first] = QString("n %1, mean %2 us, p50 %3 us, p99 %4 us, max %5 us")
+				.arg(h.second->count())
+				.arg(h.second->mean(), 0, 'f', 1)
+				.arg(h.second->percentile(50))
+				.arg(h.second->percentile(99))
+				.arg(h.second->max());
+	for (auto & v : values)
+	{
+		struct Snapshot s = { v.first, v.second, };
+		result.push_back(s);
+	}
+	return result;
+}
+
+QJsonObject Metrics::toJson(void)
+{
+QJsonObject counters, gauges, histograms, metrics;
+	runCollectors();
+	struct Registry & r(registry());
+	QMutexLocker lock(& r.mutex);
+	for (auto & c : r.counters)
+		counters[c.first] = (double) c.second->value();
+	for (auto & g : r.gauges)
+		gauges[g.first] = g.second->value();
+	for (auto & h : r.histograms)
+		histograms[h.first] = h.second->toJson();
+	metrics["counters"] = counters;
+	metrics["gauges"] = gauges;
+	metrics["histograms"] = histograms;
+	return metrics;
+}
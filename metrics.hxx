@@ -0,0 +1,134 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef METRICS_HXX
+#define METRICS_HXX
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QJsonObject>
+#include <QElapsedTimer>
+
+/* a registry of named run time metrics - counters, gauges and latency histograms
+ *
+ * metrics are created on first use and are never destroyed, so references to them can be kept, e.g. in
+ * static variables, to avoid the name lookup on hot paths:
+ *	static Metrics::Histogram & packet_time(Metrics::histogram("probe.packet-receive"));
+ *	Metrics::ScopedTimer timer(packet_time);
+ * metric names are dot-separated, the first component names the subsystem that owns the metric;
+ * updating a metric is thread safe */
+class Metrics
+{
+public:
+	class Counter
+	{
+	private:
+		std::atomic<uint64_t>	count;
+	public:
+		Counter(void) : count(0) {}
+		void increment(uint64_t n = 1) { count += n; }
+		uint64_t value(void) const { return count; }
+	};
+
+	class Gauge
+	{
+	private:
+		std::atomic<double>	current;
+	public:
+		Gauge(void) : current(0) {}
+		void set(double x) { current = x; }
+		double value(void) const { return current; }
+	};
+
+	/* a latency histogram; the samples are in microseconds, and are kept in buckets with exponentially growing
+	 * (power of 2) upper bounds, the last bucket collects all samples that do not fit in the other buckets */
+	class Histogram
+	{
+	public:
+		enum { BUCKET_COUNT = 28, };
+	private:
+		std::atomic<uint64_t>	buckets[BUCKET_COUNT];
+		std::atomic<uint64_t>	sample_count, sum, minimum, maximum;
+	public:
+		Histogram(void);
+		void record(uint64_t microseconds);
+		uint64_t count(void) const { return sample_count; }
+		uint64_t total(void) const { return sum; }
+		uint64_t min(void) const { return sample_count ? (uint64_t) minimum : 0; }
+		uint64_t max(void) const { return maximum; }
+		double mean(void) const { uint64_t n = sample_count; return n ? (double) sum / n : 0; }
+		/* estimates a percentile (0..100) - this returns the upper bound of the bucket that contains the percentile,
+		 * clamped to the maximum sample seen */
+		uint64_t percentile(double p) const;
+		static uint64_t bucketUpperBound(int bucket) { return bucket == BUCKET_COUNT - 1 ? UINT64_MAX : ((uint64_t) 1 << bucket); }
+		QJsonObject toJson(void) const;
+	};
+
+	/* records the time elapsed between construction and destruction into a histogram */
+	class ScopedTimer
+	{
+	private:
+		Histogram	& histogram;
+		QElapsedTimer	timer;
+	public:
+		ScopedTimer(Histogram & histogram) : histogram(histogram) { timer.start(); }
+		~ScopedTimer(void) { histogram.record(timer.nsecsElapsed() / 1000); }
+		/* milliseconds elapsed until now */
+		qint64 elapsed(void) const { return timer.elapsed(); }
+	};
+
+	struct Snapshot
+	{
+		QString	name;
+		QString	value;
+	};
+
+	static Counter & counter(const QString & name);
+	static Gauge & gauge(const QString & name);
+	static Histogram & histogram(const QString & name);
+	/* collectors are invoked before the metrics are read for display or export, and are meant for publishing
+	 * values that are maintained elsewhere (e.g., the libtroll query statistics) as metrics */
+	static void addCollector(std::function<void(void)> collector);
+	/* returns all metrics, sorted by name, with their values formatted for display */
+	static QVector<struct Snapshot> snapshot(void);
+	static QJsonObject toJson(void);
+
+private:
+	struct Registry
+	{
+		QMutex	mutex;
+		std::map<QString, std::unique_ptr<Counter>>	counters;
+		std::map<QString, std::unique_ptr<Gauge>>	gauges;
+		std::map<QString, std::unique_ptr<Histogram>>	histograms;
+		std::vector<std::function<void(void)>>	collectors;
+	};
+	static struct Registry & registry(void);
+	static void runCollectors(void);
+};
+
+#endif // METRICS_HXX
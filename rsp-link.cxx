@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#include "rsp-link.hxx"
+#include <QSerialPort>
+#include <QDebug>
+#include "gdb-remote.hxx"
+#include "metrics.hxx"
+#include "trace.hxx"
+
+#define READ_BUFFER_SIZE	(64 * 1024)
+
+RspLink::RspLink(const QString & port_name)
+{
+	this->port_name = port_name;
+	port = 0;
+	framer_state = WAIT_PACKET_START;
+	acknowledgements = 0;
+	is_ack_mode = true;
+	is_stop_reply_expected = false;
+	read_buffer.resize(READ_BUFFER_SIZE);
+	moveToThread(& io_thread);
+	io_thread.start();
+}
+
+RspLink::~RspLink()
+{
+	close();
+	io_thread.quit();
+	io_thread.wait();
+}
+
+bool RspLink::open(void)
+{
+	bool is_opened = false;
+	QMetaObject::invokeMethod(this, "openPort", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, is_opened));
+	return is_opened;
+}
+
+void RspLink::close(void)
+{
+	QMetaObject::invokeMethod(this, "closePort", Qt::BlockingQueuedConnection);
+	flush();
+}
+
+bool RspLink::openPort(void)
+{
+	closePort();
+	framer_state = WAIT_PACKET_START;
+	port = new QSerialPort(port_name, this);
+	if (!port->open(QSerialPort::ReadWrite) || !port->setDataTerminalReady(true))
+	{
+		delete port;
+		port = 0;
+		return false;
+	}
+	connect(port, SIGNAL(readyRead()), this, SLOT(portReadyRead()));
+	return true;
+}
+
+void RspLink::closePort(void)
+{
+	if (!port)
+		return;
+	port->close();
+	delete port;
+	port = 0;
+}
+
+void RspLink::writeData(const QByteArray & data, bool is_packet)
+{
+	if (!port)
+		return;
+	if (is_packet)
+		last_packet = data;
+	if (port->write(data) != data.length())
+		qDebug() << "error writing to the gdb server port";
+}
+
+void RspLink::portReadyRead(void)
+{
+static Metrics::Counter & bytes(Metrics::counter("rsp-link.bytes-read"));
+static Metrics::Counter & reads(Metrics::counter("rsp-link.reads"));
+qint64 length;
+	while ((length = port->read(read_buffer.data(), read_buffer.size())) > 0)
+	{
+		bytes.increment(length);
+		reads.increment();
+		framePacket(read_buffer.constData(), length);
+	}
+}
+
+void RspLink::framePacket(const char * data, int length)
+{
+static Metrics::Counter & retransmissions(Metrics::counter("rsp-link.retransmissions-requested"));
+int i;
+	for (i = 0; i < length; i ++)
+	{
+		char c = data[i];
+		switch (framer_state)
+		{
+			case WAIT_PACKET_START:
+				if (c == '$')
+					packet = "$", framer_state = PACKET_DATA;
+				else if (c == '+')
+				{
+					QMutexLocker lock(& mutex);
+					acknowledgements ++;
+					condition.wakeAll();
+				}
+				else if (c == '-' && last_packet.length())
+					retransmissions.increment(), port->write(last_packet);
+				break;
+			case PACKET_DATA:
+				packet += c;
+				if (c == '#')
+					framer_state = CHECKSUM_HIGH;
+				break;
+			case CHECKSUM_HIGH:
+				packet += c, framer_state = CHECKSUM_LOW;
+				break;
+			case CHECKSUM_LOW:
+				packet += c, framer_state = WAIT_PACKET_START;
+				packetReceived();
+				break;
+		}
+	}
+}
+
+void RspLink::packetReceived(void)
+{
+static Metrics::Counter & invalid_packets(Metrics::counter("rsp-link.invalid-packets"));
+TRACE_SPAN_CATEGORY("RspLink::packetReceived", "probe");
+QMutexLocker lock(& mutex);
+	if (!GdbRemote::isValidPacket(packet))
+	{
+		invalid_packets.increment();
+		if (is_ack_mode)
+		{
+			/* request retransmission */
+			port->write("-");
+			return;
+		}
+	}
+	else if (is_ack_mode)
+		port->write("+");
+	if (is_stop_reply_expected)
+	{
+		auto data = GdbRemote::packetData(packet);
+		if (data.length() && QByteArray("TSWX").contains(data.at(0)))
+		{
+			is_stop_reply_expected = false;
+			emit stopReplyReceived(packet);
+			return;
+		}
+		if (data.length() && data.at(0) == 'O' && data != "OK")
+		{
+			/* console output from the target, while it is running */
+			qDebug() << "target output:" << QByteArray::fromHex(data.mid(1));
+			return;
+		}
+	}
+	packets.enqueue(packet);
+	condition.wakeAll();
+}
+
+bool RspLink::putPacket(const QByteArray & packet, unsigned long timeout_ms)
+{
+	QMetaObject::invokeMethod(this, "writeData", Qt::QueuedConnection, Q_ARG(QByteArray, packet), Q_ARG(bool, true));
+	QMutexLocker lock(& mutex);
+	if (!is_ack_mode)
+		return true;
+	while (!acknowledgements)
+		if (!condition.wait(& mutex, timeout_ms))
+			return false;
+	acknowledgements --;
+	return true;
+}
+
+QByteArray RspLink::getPacket(unsigned long timeout_ms)
+{
+	QMutexLocker lock(& mutex);
+	while (packets.isEmpty())
+		if (!condition.wait(& mutex, timeout_ms))
+			return QByteArray();
+	return packets.dequeue();
+}
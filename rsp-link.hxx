@@ -0,0 +1,93 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef RSPLINK_HXX
+#define RSPLINK_HXX
+
+#include <limits.h>
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QByteArray>
+#include <QString>
+
+class QSerialPort;
+
+/* a gdb remote serial protocol link over a serial port
+ *
+ * the serial port is owned by a dedicated input/output thread, which reads all available data as soon as it arrives,
+ * and runs it through an incremental packet framer; acknowledgements are sent (unless in no-ack mode) and counted by the
+ * input/output thread, and the completed packets are queued, to be fetched by the thread that uses the link with
+ * 'getPacket()'; stop replies received while the target is running are instead delivered by the 'stopReplyReceived()'
+ * signal, which is queued to the thread that uses the link */
+class RspLink : public QObject
+{
+	Q_OBJECT
+private:
+	QThread		io_thread;
+	QString		port_name;
+	/* the members below are only accessed from the input/output thread */
+	QSerialPort	* port;
+	enum { WAIT_PACKET_START, PACKET_DATA, CHECKSUM_HIGH, CHECKSUM_LOW, } framer_state;
+	QByteArray	packet;
+	/* the last packet sent, retransmitted if the remote end requests so */
+	QByteArray	last_packet;
+	/* incoming data is read in this buffer - usually, all data available is read at once */
+	QByteArray	read_buffer;
+	void framePacket(const char * data, int length);
+	void packetReceived(void);
+
+	/* the members below are shared between the threads, and are protected by 'mutex' */
+	QMutex		mutex;
+	QWaitCondition	condition;
+	QQueue<QByteArray>	packets;
+	int		acknowledgements;
+	bool		is_ack_mode;
+	bool		is_stop_reply_expected;
+private slots:
+	bool openPort(void);
+	void closePort(void);
+	void writeData(const QByteArray & data, bool is_packet);
+	void portReadyRead(void);
+signals:
+	void stopReplyReceived(const QByteArray & packet);
+public:
+	RspLink(const QString & port_name);
+	~RspLink();
+	bool open(void);
+	void close(void);
+	/* writes raw data (e.g. an interrupt request) to the link, without waiting for an acknowledgement */
+	void write(const QByteArray & data) { QMetaObject::invokeMethod(this, "writeData", Qt::QueuedConnection, Q_ARG(QByteArray, data), Q_ARG(bool, false)); }
+	/* sends a packet; unless in no-ack mode, also waits for the packet to be acknowledged - returns false on timeout */
+	bool putPacket(const QByteArray & packet, unsigned long timeout_ms = ULONG_MAX);
+	/* returns the next packet received, or an empty byte array on timeout */
+	QByteArray getPacket(unsigned long timeout_ms = ULONG_MAX);
+	/* discards all packets and acknowledgements received */
+	void flush(void) { QMutexLocker lock(& mutex); packets.clear(); acknowledgements = 0; }
+	void setAckMode(bool is_ack_mode) { QMutexLocker lock(& mutex); this->is_ack_mode = is_ack_mode; }
+	/* makes the next stop reply be delivered by the 'stopReplyReceived()' signal, instead of being queued; must be called
+	 * before requesting the target to run */
+	void expectStopReply(void) { QMutexLocker lock(& mutex); is_stop_reply_expected = true; }
+};
+
+#endif // RSPLINK_HXX
@@ -20,6 +20,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 #include "sforth.hxx"
+#include "metrics.hxx"
+#include "trace.hxx"
 
 extern "C"
 {
@@ -51,6 +53,9 @@ Sforth::Sforth(QPlainTextEdit * console)
 
 void Sforth::evaluate(const QString &sforth_commands)
 {
+static Metrics::Histogram & evaluation_time(Metrics::histogram("sforth.evaluate"));
+Metrics::ScopedTimer timer(evaluation_time);
+TRACE_SPAN_CATEGORY("Sforth::evaluate", "sforth");
 	sforth_console->appendPlainText(QString(">>> ") + sforth_commands);
 	sf_eval(sforth_commands.toLocal8Bit().data());
 }
@@ -0,0 +1,89 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#include "source-file-cache.hxx"
+#include <string.h>
+#include <QFile>
+#include <QFileInfo>
+
+QString SourceFileCache::SourceFile::expandedLine(int line_number) const
+{
+	if (line_number < 1 || line_number > lineCount())
+		return QString();
+	int start = line_offsets.at(line_number - 1);
+	return QString::fromUtf8(contents.constData() + start, line_offsets.at(line_number) - start).replace('\t', "        ").remove('\r');
+}
+
+QString SourceFileCache::resolvedPath(const QString & source_filename, const QString & directory_name, const QString & compilation_directory)
+{
+	QString key = source_filename + QChar(0) + directory_name + QChar(0) + compilation_directory;
+	auto x = resolved_paths.constFind(key);
+	if (x != resolved_paths.constEnd())
+	{
+		if (QFileInfo(x.value()).exists())
+			return x.value();
+		resolved_paths.remove(key);
+	}
+
+	QFileInfo finfo(directory_name + "/" + source_filename);
+	if (!finfo.exists())
+		finfo.setFile(compilation_directory + "/" + source_filename);
+	if (!finfo.exists())
+		finfo.setFile(compilation_directory + "/" + directory_name + "/" + source_filename);
+	QString path = finfo.canonicalFilePath();
+	/* do not remember files that are not found - they may appear later (e.g., generated sources) */
+	if (!path.isEmpty())
+		resolved_paths[key] = path;
+	return path;
+}
+
+const struct SourceFileCache::SourceFile * SourceFileCache::sourceFile(const QString & path)
+{
+	if (path.isEmpty())
+		return 0;
+	QFileInfo finfo(path);
+	auto x = files.constFind(path);
+	if (x != files.constEnd())
+	{
+		if (finfo.exists() && finfo.size() == x.value()->size && finfo.lastModified() == x.value()->modification_time)
+			return x.value().get();
+		/* the file has been changed, or removed - reread it */
+		files.remove(path);
+	}
+
+	QFile file(path);
+	if (!file.open(QFile::ReadOnly))
+		return 0;
+	std::shared_ptr<struct SourceFile> f(new SourceFile);
+	f->path = path;
+	f->modification_time = finfo.lastModified();
+	f->contents = file.readAll();
+	/* the size recorded is the size that was actually read; if the file was being written while being read, the
+	 * size will most likely not match the size on disk, and the file will be reread on the next access */
+	f->size = f->contents.size();
+
+	const char * p = f->contents.constData(), * end = p + f->contents.size(), * line;
+	for (line = p; line < end; line = (const char *) memchr(line, '\n', end - line), line = line ? line + 1 : end)
+		f->line_offsets.push_back(line - p);
+	f->line_offsets.push_back(f->contents.size());
+	files[path] = f;
+	return f.get();
+}
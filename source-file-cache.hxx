@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef SOURCEFILECACHE_HXX
+#define SOURCEFILECACHE_HXX
+
+#include <memory>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QCache>
+#include <QDateTime>
+
+/* a cache of source code files
+ *
+ * the source files are read when first accessed, and an index of the line start offsets is built for them;
+ * the mapping of the file and directory names, as recorded in the debug information, to paths of existing files
+ * is also cached, as are the rendered (i.e., line numbered and tab expanded) texts of the source code views;
+ * the size and modification time of a cached file are checked on each access, and the file is reread if it
+ * has changed on disk (the files are copied, not memory mapped, so that they can be safely edited while being
+ * displayed); files which cannot be found or opened are not remembered, and are searched for again on each access */
+class SourceFileCache
+{
+public:
+	struct SourceFile
+	{
+		QString		path;
+		QByteArray	contents;
+		/* the size and modification time of the file when it was read */
+		qint64		size;
+		QDateTime	modification_time;
+		/* the offsets in 'contents' of the starts of the lines, the entry for line number 'n' is at index 'n - 1';
+		 * there is one additional entry at the end, which is the size of the file */
+		QVector<int>	line_offsets;
+		int lineCount(void) const { return line_offsets.size() - 1; }
+		/* returns a line, with tabs expanded and carriage returns removed; line numbers start at 1 */
+		QString expandedLine(int line_number) const;
+		/* returns a string which changes whenever the file is changed on disk; suitable for use in rendered view keys */
+		QString stamp(void) const { return QString("%1@%2").arg(size).arg(modification_time.toMSecsSinceEpoch()); }
+	};
+	/* a source code view, as displayed in the source code window, along with the positions in the text document of the source
+	 * code lines and of the machine instructions (if disassembly is shown) */
+	struct RenderedView
+	{
+		QString	text;
+		QMap<int /* line number */, int /* line position in text document */> line_positions;
+		QMap<uint32_t /* address */, int /* line position in text document */> address_positions;
+	};
+
+	/* returns the canonical path of a source file, or an empty string if the file cannot be found */
+	QString resolvedPath(const QString & source_filename, const QString & directory_name, const QString & compilation_directory);
+	/* returns null if the file cannot be opened; the returned pointer is only valid until the next call */
+	const struct SourceFile * sourceFile(const QString & path);
+	/* returns null if the view has not been rendered, or if it has been evicted from the cache */
+	std::shared_ptr<const struct RenderedView> renderedView(const QString & key)
+	{ auto x = rendered_views.object(key); return x ? * x : std::shared_ptr<const struct RenderedView>(); }
+	void insertRenderedView(const QString & key, const std::shared_ptr<const struct RenderedView> & view)
+	{ rendered_views.insert(key, new std::shared_ptr<const struct RenderedView>(view), view->text.length()); }
+
+	SourceFileCache(void) : rendered_views(/* maximum number of characters in the cached source code views */ 16 * 1024 * 1024) {}
+private:
+	QHash<QString, QString>	resolved_paths;
+	QHash<QString, std::shared_ptr<struct SourceFile> > files;
+	QCache<QString, std::shared_ptr<const struct RenderedView> > rendered_views;
+};
+
+#endif // SOURCEFILECACHE_HXX
@@ -0,0 +1,227 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#include <algorithm>
+#include "target-memory-cache.hxx"
+#include "metrics.hxx"
+#include "trace.hxx"
+
+/* the default number of blocks read ahead of the last missing block of a run of missing blocks */
+#define DEFAULT_READ_AHEAD_BLOCKS	4
+
+TargetMemoryCache::TargetMemoryCache(Target * target_controller)
+{
+	target = target_controller;
+	read_ahead_blocks = DEFAULT_READ_AHEAD_BLOCKS;
+	cache_generation = 0;
+	is_flash_image_valid = false;
+	QObject::connect(target, SIGNAL(targetHalted(TARGET_HALT_REASON)), this, SLOT(targetControllerHalted(TARGET_HALT_REASON)));
+	QObject::connect(target, SIGNAL(targetRunning()), this, SIGNAL(targetRunning()));
+}
+
+uint64_t TargetMemoryCache::areaEnd(uint32_t address, int length)
+{
+	int i;
+	for (i = 0; i < ram_areas.size(); i ++)
+		if (ram_areas.at(i).start <= address && (uint64_t) address + length <= (uint64_t) ram_areas.at(i).start + ram_areas.at(i).length)
+			return (uint64_t) ram_areas.at(i).start + ram_areas.at(i).length;
+	for (i = 0; i < flash_areas.size(); i ++)
+		if (flash_areas.at(i).start <= address && (uint64_t) address + length <= (uint64_t) flash_areas.at(i).start + flash_areas.at(i).length)
+			return (uint64_t) flash_areas.at(i).start + flash_areas.at(i).length;
+	return 0;
+}
+
+bool TargetMemoryCache::flashImageBytes(uint32_t address, int length, QByteArray & data)
+{
+static Metrics::Counter & reads(Metrics::counter("memory-cache.flash-image-reads"));
+static Metrics::Counter & bytes(Metrics::counter("memory-cache.flash-image-bytes-read"));
+int i;
+uint64_t end = (uint64_t) address + length;
+	if (!is_flash_image_valid || length <= 0)
+		return false;
+	for (i = 0; i < flash_areas.size(); i ++)
+		if (flash_areas.at(i).start <= address && end <= (uint64_t) flash_areas.at(i).start + flash_areas.at(i).length)
+			break;
+	if (i == flash_areas.size())
+		return false;
+	for (i = 0; i < volatile_flash_ranges.size(); i ++)
+		if (address < (uint64_t) volatile_flash_ranges.at(i).start + volatile_flash_ranges.at(i).length && volatile_flash_ranges.at(i).start < end)
+			return false;
+	for (i = 0; i < flash_image.ranges.size(); i ++)
+		if (flash_image.ranges.at(i).address <= address && end <= (uint64_t) flash_image.ranges.at(i).address + flash_image.ranges.at(i).data.size())
+		{
+			data = flash_image.ranges.at(i).data.mid(address - flash_image.ranges.at(i).address, length);
+			reads.increment();
+			bytes.increment(length);
+			return true;
+		}
+	return false;
+}
+
+void TargetMemoryCache::fetchBlocks(const QVector<struct memory_range> & ranges)
+{
+static Metrics::Counter & blocks_read(Metrics::counter("memory-cache.blocks-read"));
+static Metrics::Counter & read_ahead_blocks_read(Metrics::counter("memory-cache.read-ahead-blocks-read"));
+TRACE_SPAN_CATEGORY("TargetMemoryCache::fetchBlocks", "probe");
+std::vector<uint32_t> missing;
+QVector<struct memory_range> runs, retries;
+uint32_t block, start;
+uint64_t end, area_end;
+int i, n;
+
+	for (i = 0; i < ranges.size(); i ++)
+		for (block = ranges.at(i).address & ~(BLOCK_SIZE - 1); block < ranges.at(i).address + ranges.at(i).length; block += BLOCK_SIZE)
+			if (!blocks.contains(block))
+				missing.push_back(block);
+	std::sort(missing.begin(), missing.end());
+	missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+	/* coalesce the missing blocks into runs of adjacent blocks, and extend each run with the read-ahead
+	 * blocks that follow it, up to the first cached block or the end of the memory area */
+	for (i = 0; i < missing.size();)
+	{
+		start = missing.at(i ++);
+		end = (uint64_t) start + BLOCK_SIZE;
+		area_end = areaEnd(start, BLOCK_SIZE);
+		while (1)
+		{
+			if (i < missing.size() && missing.at(i) == end)
+			{
+				end += BLOCK_SIZE, i ++;
+				continue;
+			}
+			for (n = 0; n < read_ahead_blocks && end + BLOCK_SIZE <= area_end && !blocks.contains(end)
+				&& !(i < missing.size() && missing.at(i) == end); n ++)
+				end += BLOCK_SIZE;
+			read_ahead_blocks_read.increment(n);
+			if (!(i < missing.size() && missing.at(i) == end))
+				break;
+		}
+		runs.push_back((struct memory_range) { .address = start, .length = (int) (end - start), });
+	}
+
+	auto data = target->readScatter(runs);
+	for (i = 0; i < runs.size(); i ++)
+	{
+		if (data.at(i).size() != runs.at(i).length)
+		{
+			/* a read-ahead block may not be readable - retry reading the blocks of the run one by one */
+			for (n = 0; n < runs.at(i).length; n += BLOCK_SIZE)
+				retries.push_back((struct memory_range) { .address = runs.at(i).address + n, .length = BLOCK_SIZE, });
+			continue;
+		}
+		for (n = 0; n < runs.at(i).length; n += BLOCK_SIZE)
+			blocks.insert(runs.at(i).address + n, data.at(i).mid(n, BLOCK_SIZE));
+		blocks_read.increment(runs.at(i).length / BLOCK_SIZE);
+	}
+	if (retries.isEmpty())
+		return;
+	data = target->readScatter(retries);
+	for (i = 0; i < retries.size(); i ++)
+		if (data.at(i).size() == BLOCK_SIZE)
+			blocks.insert(retries.at(i).address, data.at(i)), blocks_read.increment();
+}
+
+bool TargetMemoryCache::cachedBytes(uint32_t address, int length, QByteArray & data)
+{
+uint32_t block, offset;
+int n;
+	data.clear();
+	for (block = address & ~(BLOCK_SIZE - 1), offset = address - block; data.size() < length; block += BLOCK_SIZE, offset = 0)
+	{
+		auto x = blocks.constFind(block);
+		if (x == blocks.constEnd())
+			return false;
+		n = Util::min(length - data.size(), (int) (BLOCK_SIZE - offset));
+		data.append(x.value().constData() + offset, n);
+	}
+	return true;
+}
+
+uint32_t TargetMemoryCache::readWord(uint32_t address)
+{
+	auto x = readBytes(address, sizeof(uint32_t), true);
+	if (x.size() != sizeof(uint32_t))
+		/* let the target controller report the error */
+		return target->readWord(address);
+	return * (uint32_t *) x.constData();
+}
+
+QByteArray TargetMemoryCache::readBytes(uint32_t address, int byte_count, bool is_failure_allowed)
+{
+static Metrics::Counter & hits(Metrics::counter("memory-cache.hits"));
+static Metrics::Counter & misses(Metrics::counter("memory-cache.misses"));
+static Metrics::Gauge & hit_rate(Metrics::gauge("memory-cache.hit-rate-percent"));
+QByteArray data;
+	if (flashImageBytes(address, byte_count, data))
+		return data;
+	if (byte_count <= 0 || byte_count > MAX_CACHED_READ_SIZE || !areaEnd(address, byte_count))
+		return target->readBytes(address, byte_count, is_failure_allowed);
+	if (cachedBytes(address, byte_count, data))
+		hits.increment();
+	else
+	{
+		misses.increment();
+		fetchBlocks(QVector<struct memory_range>() << (struct memory_range) { .address = address, .length = byte_count, });
+		if (!cachedBytes(address, byte_count, data))
+			data = target->readBytes(address, byte_count, is_failure_allowed);
+	}
+	hit_rate.set(100. * hits.value() / (hits.value() + misses.value()));
+	return data;
+}
+
+QVector<QByteArray> TargetMemoryCache::readScatter(const QVector<struct memory_range> & ranges)
+{
+static Metrics::Counter & hits(Metrics::counter("memory-cache.hits"));
+static Metrics::Counter & misses(Metrics::counter("memory-cache.misses"));
+static Metrics::Gauge & hit_rate(Metrics::gauge("memory-cache.hit-rate-percent"));
+QVector<QByteArray> data(ranges.size());
+QVector<struct memory_range> missed, uncached;
+QVector<int> missed_indices, uncached_indices;
+int i;
+
+	for (i = 0; i < ranges.size(); i ++)
+	{
+		if (flashImageBytes(ranges.at(i).address, ranges.at(i).length, data[i]))
+			continue;
+		if (ranges.at(i).length <= 0 || ranges.at(i).length > MAX_CACHED_READ_SIZE || !areaEnd(ranges.at(i).address, ranges.at(i).length))
+			uncached.push_back(ranges.at(i)), uncached_indices.push_back(i);
+		else if (cachedBytes(ranges.at(i).address, ranges.at(i).length, data[i]))
+			hits.increment();
+		else
+			missed.push_back(ranges.at(i)), missed_indices.push_back(i), misses.increment();
+	}
+	/* all missing blocks are read with a single scattered read */
+	if (!missed.isEmpty())
+		fetchBlocks(missed);
+	for (i = 0; i < missed.size(); i ++)
+		if (!cachedBytes(missed.at(i).address, missed.at(i).length, data[missed_indices.at(i)]))
+			uncached.push_back(missed.at(i)), uncached_indices.push_back(missed_indices.at(i));
+	if (!uncached.isEmpty())
+	{
+		auto x = target->readScatter(uncached);
+		for (i = 0; i < uncached.size(); i ++)
+			data[uncached_indices.at(i)] = x.at(i);
+	}
+	if (hits.value() + misses.value())
+		hit_rate.set(100. * hits.value() / (hits.value() + misses.value()));
+	return data;
+}
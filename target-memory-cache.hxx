@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TARGETMEMORYCACHE_HXX
+#define TARGETMEMORYCACHE_HXX
+
+#include <QHash>
+#include <QVector>
+#include "target.hxx"
+#include "memory.hxx"
+
+/* a target memory cache, layered around a target controller
+ *
+ * target memory is cached in aligned blocks of 'BLOCK_SIZE' bytes; on a cache miss, all missing blocks of a request
+ * are coalesced into runs of adjacent blocks, which are extended with a number of read-ahead blocks, and are read from
+ * the target with a single scattered read; only memory in the ram and flash areas of the target memory map is
+ * cached, reads of other memory (e.g. peripheral registers) are always passed to the target, as are large reads;
+ * the cache is invalidated whenever target memory may change - when the target is reset, resumed, single stepped,
+ * when flash is programmed, and when the target halts; the generation number is incremented on each invalidation
+ *
+ * once the target flash has been verified to match the executable image, by a successful 'syncFlash()', reads that fall
+ * entirely inside flash and inside the image are answered from the image, without accessing the target at all; flash
+ * ranges that the target itself may modify (e.g. data stored in flash by the application) must be marked volatile with
+ * 'addVolatileFlashRange()', reads that overlap such ranges are read from the target (through the cache) */
+class TargetMemoryCache : public Target
+{
+	Q_OBJECT
+public:
+	enum
+	{
+		BLOCK_SIZE	= 64,
+		/* reads larger than this are not cached */
+		MAX_CACHED_READ_SIZE	= 4096,
+	};
+private:
+	Target		* target;
+	QHash<uint32_t /* block address */, QByteArray>	blocks;
+	int		read_ahead_blocks;
+	uint32_t	cache_generation;
+	/* the executable image, valid if the target flash has been verified to match it */
+	Memory		flash_image;
+	bool		is_flash_image_valid;
+	/* flash ranges that may be modified by the target - only the start and length of the areas are used */
+	QVector<struct ram_area>	volatile_flash_ranges;
+	/* returns false if the range cannot be read from the flash image */
+	bool flashImageBytes(uint32_t address, int length, QByteArray & data);
+	/* returns the end address of the ram or flash area that contains the range passed, or zero if the range is not
+	 * entirely within a single area */
+	uint64_t areaEnd(uint32_t address, int length);
+	/* reads the missing blocks that cover the ranges passed, the ranges must be cacheable */
+	void fetchBlocks(const QVector<struct memory_range> & ranges);
+	/* returns false if not all blocks covering the range are cached */
+	bool cachedBytes(uint32_t address, int length, QByteArray & data);
+	void invalidate(void) { blocks.clear(); cache_generation ++; }
+private slots:
+	void targetControllerHalted(enum TARGET_HALT_REASON reason) { invalidate(); emit targetHalted(reason); }
+public:
+	/* the cache takes ownership of the target controller */
+	TargetMemoryCache(Target * target_controller);
+	~TargetMemoryCache() { delete target; }
+	void setReadAheadBlocks(int block_count) { read_ahead_blocks = block_count; }
+	uint32_t generation(void) { return cache_generation; }
+	void addVolatileFlashRange(uint32_t address, uint32_t length) { volatile_flash_ranges.push_back((struct ram_area) { .start = address, .length = length, }); }
+
+	uint32_t readWord(uint32_t address);
+	bool reset(void) { invalidate(); return target->reset(); }
+	QByteArray readBytes(uint32_t address, int byte_count, bool is_failure_allowed = false);
+	QVector<QByteArray> readScatter(const QVector<struct memory_range> & ranges);
+	bool writeBytes(uint32_t address, const QByteArray & data) { invalidate(); return target->writeBytes(address, data); }
+	/* the flash image is still used for reads of the reprogrammed flash - its contents are the original ones, which is
+	 * what should be displayed when flash is patched (e.g. with breakpoint instructions) */
+	bool writeFlashBlocks(uint32_t address, const QByteArray & data) { invalidate(); return target->writeFlashBlocks(address, data); }
+	uint32_t readRawUncachedRegister(uint32_t register_number) { return target->readRawUncachedRegister(register_number); }
+	bool breakpointSet(uint32_t address, int length) { return target->breakpointSet(address, length); }
+	bool breakpointClear(uint32_t address, int length) { return target->breakpointClear(address, length); }
+	void requestSingleStep(void) { invalidate(); target->requestSingleStep(); }
+	bool requestRangeStep(uint32_t start_address, uint32_t end_address) { invalidate(); return target->requestRangeStep(start_address, end_address); }
+	bool resume(void) { invalidate(); return target->resume(); }
+	bool requestHalt(void) { return target->requestHalt(); }
+	bool connect(void) { invalidate(); return target->connect(); }
+	uint32_t haltReason(void) { return target->haltReason(); }
+	/* the memory map is also parsed by the target controller, which needs it for programming flash */
+	QByteArray memoryMap(void) { auto s = target->memoryMap(); target->parseMemoryAreas(s); return s; }
+	bool syncFlash(const Memory & memory_contents) { bool result = target->syncFlash(memory_contents); invalidate(); if ((is_flash_image_valid = result)) flash_image = memory_contents; return result; }
+};
+
+#endif // TARGETMEMORYCACHE_HXX
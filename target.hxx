@@ -26,6 +26,7 @@ THE SOFTWARE.
 #include <QObject>
 #include <QDebug>
 #include <QXmlStreamReader>
+#include <QVector>
 #include <list>
 
 #include "util.hxx"
@@ -63,13 +64,37 @@ public:
 		uint32_t	length;
 		unsigned	blocksize;
 	};
+	struct memory_range
+	{
+		uint32_t	address;
+		int		length;
+	};
 	virtual uint32_t readWord(uint32_t address) = 0;
 	virtual bool reset(void) = 0;
 	virtual QByteArray readBytes(uint32_t address, int byte_count, bool is_failure_allowed = false) = 0;
+	/* reads a list of memory ranges, the data for each range is returned at the same position in the returned
+	 * vector, a range that cannot be read is returned as an empty byte array; the ranges are read one by one
+	 * here, targets that can batch the reads in less round trips to the probe should override this */
+	virtual QVector<QByteArray> readScatter(const QVector<struct memory_range> & ranges)
+	{
+		QVector<QByteArray> data;
+		int i;
+		for (i = 0; i < ranges.size(); i ++)
+			data.push_back(readBytes(ranges.at(i).address, ranges.at(i).length, true));
+		return data;
+	}
+	/* writes target memory; returns false on error, or if the target does not support writing memory */
+	virtual bool writeBytes(uint32_t address, const QByteArray & data) { return false; }
+	/* erases and reprograms flash, the address and the size of the data must be aligned to the flash block size;
+	 * returns false on error, or if the target does not support programming flash in this way */
+	virtual bool writeFlashBlocks(uint32_t address, const QByteArray & data) { return false; }
 	virtual uint32_t readRawUncachedRegister(uint32_t register_number) = 0;
 	virtual bool breakpointSet(uint32_t address, int length) = 0;
 	virtual bool breakpointClear(uint32_t address, int length) = 0;
 	virtual void requestSingleStep(void) = 0;
+	/* runs the target until the program counter leaves the address range passed (range stepping); returns false,
+	 * without running the target, if the target does not support range stepping */
+	virtual bool requestRangeStep(uint32_t start_address, uint32_t end_address) { return false; }
 	virtual bool resume(void) = 0;
 	virtual bool requestHalt(void) = 0;
 	virtual bool connect(void) = 0;
@@ -145,6 +170,24 @@ public:
 			ranges.clear();
 		return ranges;
 	}
+	bool isRamAddress(uint32_t address)
+	{
+		int i;
+		for (i = 0; i < ram_areas.size(); i ++)
+			if (ram_areas[i].start <= address && address - ram_areas[i].start < ram_areas[i].length)
+				return true;
+		return false;
+	}
+	/* returns the start address and the size of the flash block that contains the address passed, or a pair of zeros
+	 * if the address is not in flash */
+	std::pair<uint32_t, uint32_t> flashBlockForAddress(uint32_t address)
+	{
+		int i;
+		for (i = 0; i < flash_areas.size(); i ++)
+			if (flash_areas[i].start <= address && address - flash_areas[i].start < flash_areas[i].length && flash_areas[i].blocksize)
+				return std::pair<uint32_t, uint32_t>(address - (address - flash_areas[i].start) % flash_areas[i].blocksize, flash_areas[i].blocksize);
+		return std::pair<uint32_t, uint32_t>(0, 0);
+	}
 protected:
 	std::vector<struct ram_area> ram_areas;
 	std::vector<struct flash_area> flash_areas;
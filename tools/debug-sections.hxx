@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef DEBUGSECTIONS_HXX
+#define DEBUGSECTIONS_HXX
+
+#include <string>
+#include <elfio/elfio.hpp>
+#include "libtroll.hxx"
+
+/* the debug information sections of an elf file, as used by the command line libtroll tools; the section
+ * contents are copied out of the elf file, so that they outlive the elf reader - the dwarf data and
+ * unwinder objects, created by this class, refer to them, and must not outlive the DebugSections object */
+struct DebugSections
+{
+	std::string	debug_aranges, debug_info, debug_abbrev, debug_frame, debug_ranges, debug_str, debug_line, debug_loc;
+	/* returns an empty string on success, or an error message otherwise */
+	std::string load(const char * elf_filename)
+	{
+		ELFIO::elfio elf;
+		int i;
+		if (!elf.load(elf_filename))
+			return std::string("cannot read elf file ") + elf_filename;
+		if (elf.get_class() != ELFCLASS32 || elf.get_encoding() != ELFDATA2LSB)
+			return "only 32 bit, little-endian encoded elf files are supported";
+		for (i = /* section number zero - unused (null section) */ 1; i < elf.sections.size(); i ++)
+		{
+			auto name = elf.sections[i]->get_name();
+			std::string contents = elf.sections[i]->get_data() ? std::string(elf.sections[i]->get_data(), elf.sections[i]->get_size()) : std::string();
+			if (name == ".debug_aranges") debug_aranges = contents;
+			else if (name == ".debug_info") debug_info = contents;
+			else if (name == ".debug_abbrev") debug_abbrev = contents;
+			else if (name == ".debug_frame") debug_frame = contents;
+			else if (name == ".debug_ranges") debug_ranges = contents;
+			else if (name == ".debug_str") debug_str = contents;
+			else if (name == ".debug_line") debug_line = contents;
+			else if (name == ".debug_loc") debug_loc = contents;
+		}
+		if (debug_info.empty() || debug_abbrev.empty())
+			return "no dwarf debug information found";
+		return "";
+	}
+	DwarfData * dwarfData(void)
+	{
+		return new DwarfData(debug_aranges.data(), debug_aranges.size(),
+			debug_info.data(), debug_info.size(),
+			debug_abbrev.data(), debug_abbrev.size(),
+			debug_ranges.data(), debug_ranges.size(),
+			debug_str.data(), debug_str.size(),
+			debug_line.data(), debug_line.size(),
+			debug_loc.data(), debug_loc.size());
+	}
+	DwarfUnwinder * dwarfUnwinder(void) { return new DwarfUnwinder(debug_frame.data(), debug_frame.size()); }
+};
+
+#endif // DEBUGSECTIONS_HXX
@@ -0,0 +1,748 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* synthetic dwarf generator - writes a 32 bit, little-endian arm elf file, with debug information of
+ * configurable size, for exercising the dwarf engine with data sets much larger than the available
+ * firmware images
+ *
+ * usage: dwarf-generator [options] -o elf-file
+ *
+ * options (all of them take a number as an argument):
+ *	--cus=n			number of compilation units
+ *	--dies-per-cu=n		approximate number of debug information entries per compilation unit;
+ *				subprograms are added to a compilation unit until this number is reached
+ *	--struct-depth=n	nesting depth of the structure types chain in each compilation unit
+ *	--inlined=n		number of inlined subroutines in each subprogram
+ *	--loclists=n		number of parameters of each subprogram described by location lists
+ *	--line-rows=n		number of line number table rows for each subprogram
+ *
+ * the generated debug information is dwarf version 4 for the .debug_info section, and dwarf version 2
+ * for the .debug_line section - this is what the troll understands; the .text section contains valid,
+ * but meaningless, thumb code - each subprogram pushes r7 and lr, executes a number of 'nop' instructions,
+ * and pops r7 and pc, and the .debug_frame section describes exactly this */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <dwarf.h>
+
+static void panic(const char * message)
+{
+	fprintf(stderr, "dwarf-generator: %s\n", message);
+	exit(1);
+}
+
+/* a little-endian byte stream, used for building the contents of the generated sections */
+struct ByteStream
+{
+	std::string	bytes;
+	uint32_t size(void) const { return bytes.size(); }
+	void u8(uint8_t x) { bytes.push_back(x); }
+	void u16(uint16_t x) { u8(x), u8(x >> 8); }
+	void u32(uint32_t x) { u16(x), u16(x >> 16); }
+	void uleb(uint32_t x) { do u8((x & 0x7f) | (x > 0x7f ? 0x80 : 0)); while (x >>= 7); }
+	void sleb(int32_t x)
+	{
+		bool done;
+		do
+		{
+			uint8_t b = x & 0x7f;
+			x >>= 7;
+			done = (x == 0 && !(b & 0x40)) || (x == -1 && (b & 0x40));
+			u8(b | (done ? 0 : 0x80));
+		}
+		while (!done);
+	}
+	void str(const char * s) { bytes.append(s, strlen(s) + 1); }
+	void append(const ByteStream & s) { bytes += s.bytes; }
+	void patch32(uint32_t offset, uint32_t x) { int i; for (i = 0; i < 4; i ++, x >>= 8) bytes.at(offset + i) = x; }
+	void align(int alignment, uint8_t fill = 0) { while (size() % alignment) u8(fill); }
+};
+
+/* the .debug_str section; identical strings are only stored once */
+struct StringTable
+{
+	ByteStream			s;
+	std::map<std::string, uint32_t>	offsets;
+	uint32_t offset(const std::string & string)
+	{
+		auto x = offsets.find(string);
+		if (x != offsets.end())
+			return x->second;
+		uint32_t offset(s.size());
+		s.str(string.c_str());
+		return offsets[string] = offset;
+	}
+};
+
+/* the abbreviation codes used in the generated .debug_info section; all compilation units share
+ * a single abbreviation table, at offset zero in the .debug_abbrev section */
+enum
+{
+	ABBREV_COMPILE_UNIT = 1,
+	ABBREV_BASE_TYPE,
+	ABBREV_STRUCTURE_TYPE,
+	ABBREV_MEMBER,
+	ABBREV_POINTER_TYPE,
+	ABBREV_ARRAY_TYPE,
+	ABBREV_SUBRANGE_TYPE,
+	ABBREV_GLOBAL_VARIABLE,
+	ABBREV_ABSTRACT_SUBPROGRAM,
+	ABBREV_ABSTRACT_PARAMETER,
+	ABBREV_SUBPROGRAM,
+	ABBREV_LOCATION_LIST_PARAMETER,
+	ABBREV_PARAMETER,
+	ABBREV_VARIABLE,
+	ABBREV_LEXICAL_BLOCK,
+	ABBREV_INLINED_SUBROUTINE,
+	ABBREV_INLINED_PARAMETER,
+	ABBREV_CALL_SITE,
+	ABBREV_CALL_SITE_PARAMETER,
+};
+
+static void writeAbbreviations(ByteStream & s)
+{
+	struct { uint32_t code, tag; bool has_children; std::vector<std::pair<uint32_t, uint32_t> > attributes; } abbreviations[] =
+	{
+		{ ABBREV_COMPILE_UNIT, DW_TAG_compile_unit, true, { { DW_AT_producer, DW_FORM_strp }, { DW_AT_language, DW_FORM_data1 },
+			{ DW_AT_name, DW_FORM_strp }, { DW_AT_comp_dir, DW_FORM_strp }, { DW_AT_low_pc, DW_FORM_addr },
+			{ DW_AT_high_pc, DW_FORM_data4 }, { DW_AT_stmt_list, DW_FORM_sec_offset }, }, },
+		{ ABBREV_BASE_TYPE, DW_TAG_base_type, false, { { DW_AT_name, DW_FORM_strp }, { DW_AT_encoding, DW_FORM_data1 },
+			{ DW_AT_byte_size, DW_FORM_data1 }, }, },
+		{ ABBREV_STRUCTURE_TYPE, DW_TAG_structure_type, true, { { DW_AT_name, DW_FORM_strp }, { DW_AT_byte_size, DW_FORM_data2 },
+			{ DW_AT_decl_file, DW_FORM_data1 }, { DW_AT_decl_line, DW_FORM_data2 }, { DW_AT_sibling, DW_FORM_ref4 }, }, },
+		{ ABBREV_MEMBER, DW_TAG_member, false, { { DW_AT_name, DW_FORM_strp }, { DW_AT_decl_file, DW_FORM_data1 },
+			{ DW_AT_decl_line, DW_FORM_data2 }, { DW_AT_type, DW_FORM_ref4 }, { DW_AT_data_member_location, DW_FORM_data2 }, }, },
+		{ ABBREV_POINTER_TYPE, DW_TAG_pointer_type, false, { { DW_AT_byte_size, DW_FORM_data1 }, { DW_AT_type, DW_FORM_ref4 }, }, },
+		{ ABBREV_ARRAY_TYPE, DW_TAG_array_type, true, { { DW_AT_type, DW_FORM_ref4 }, { DW_AT_sibling, DW_FORM_ref4 }, }, },
+		{ ABBREV_SUBRANGE_TYPE, DW_TAG_subrange_type, false, { { DW_AT_type, DW_FORM_ref4 }, { DW_AT_upper_bound, DW_FORM_data1 }, }, },
+		{ ABBREV_GLOBAL_VARIABLE, DW_TAG_variable, false, { { DW_AT_name, DW_FORM_strp }, { DW_AT_decl_file, DW_FORM_data1 },
+			{ DW_AT_decl_line, DW_FORM_data2 }, { DW_AT_type, DW_FORM_ref4 }, { DW_AT_external, DW_FORM_flag_present },
+			{ DW_AT_location, DW_FORM_exprloc }, }, },
+		{ ABBREV_ABSTRACT_SUBPROGRAM, DW_TAG_subprogram, true, { { DW_AT_name, DW_FORM_strp }, { DW_AT_decl_file, DW_FORM_data1 },
+			{ DW_AT_decl_line, DW_FORM_data2 }, { DW_AT_prototyped, DW_FORM_flag_present }, { DW_AT_type, DW_FORM_ref4 },
+			{ DW_AT_inline, DW_FORM_data1 }, { DW_AT_sibling, DW_FORM_ref4 }, }, },
+		{ ABBREV_ABSTRACT_PARAMETER, DW_TAG_formal_parameter, false, { { DW_AT_name, DW_FORM_strp }, { DW_AT_decl_file, DW_FORM_data1 },
+			{ DW_AT_decl_line, DW_FORM_data2 }, { DW_AT_type, DW_FORM_ref4 }, }, },
+		{ ABBREV_SUBPROGRAM, DW_TAG_subprogram, true, { { DW_AT_external, DW_FORM_flag_present }, { DW_AT_name, DW_FORM_strp },
+			{ DW_AT_decl_file, DW_FORM_data1 }, { DW_AT_decl_line, DW_FORM_data4 }, { DW_AT_prototyped, DW_FORM_flag_present },
+			{ DW_AT_type, DW_FORM_ref4 }, { DW_AT_low_pc, DW_FORM_addr }, { DW_AT_high_pc, DW_FORM_data4 },
+			{ DW_AT_frame_base, DW_FORM_exprloc }, { DW_AT_GNU_all_call_sites, DW_FORM_flag_present }, { DW_AT_sibling, DW_FORM_ref4 }, }, },
+		{ ABBREV_LOCATION_LIST_PARAMETER, DW_TAG_formal_parameter, false, { { DW_AT_name, DW_FORM_strp }, { DW_AT_decl_file, DW_FORM_data1 },
+			{ DW_AT_decl_line, DW_FORM_data4 }, { DW_AT_type, DW_FORM_ref4 }, { DW_AT_location, DW_FORM_sec_offset }, }, },
+		{ ABBREV_PARAMETER, DW_TAG_formal_parameter, false, { { DW_AT_name, DW_FORM_strp }, { DW_AT_decl_file, DW_FORM_data1 },
+			{ DW_AT_decl_line, DW_FORM_data4 }, { DW_AT_type, DW_FORM_ref4 }, { DW_AT_location, DW_FORM_exprloc }, }, },
+		{ ABBREV_VARIABLE, DW_TAG_variable, false, { { DW_AT_name, DW_FORM_strp }, { DW_AT_decl_file, DW_FORM_data1 },
+			{ DW_AT_decl_line, DW_FORM_data4 }, { DW_AT_type, DW_FORM_ref4 }, { DW_AT_location, DW_FORM_exprloc }, }, },
+		{ ABBREV_LEXICAL_BLOCK, DW_TAG_lexical_block, true, { { DW_AT_ranges, DW_FORM_sec_offset }, { DW_AT_sibling, DW_FORM_ref4 }, }, },
+		{ ABBREV_INLINED_SUBROUTINE, DW_TAG_inlined_subroutine, true, { { DW_AT_abstract_origin, DW_FORM_ref4 },
+			{ DW_AT_low_pc, DW_FORM_addr }, { DW_AT_high_pc, DW_FORM_data4 }, { DW_AT_call_file, DW_FORM_data1 },
+			{ DW_AT_call_line, DW_FORM_data4 }, { DW_AT_sibling, DW_FORM_ref4 }, }, },
+		{ ABBREV_INLINED_PARAMETER, DW_TAG_formal_parameter, false, { { DW_AT_abstract_origin, DW_FORM_ref4 }, { DW_AT_location, DW_FORM_exprloc }, }, },
+		{ ABBREV_CALL_SITE, DW_TAG_GNU_call_site, true, { { DW_AT_low_pc, DW_FORM_addr }, { DW_AT_abstract_origin, DW_FORM_ref4 },
+			{ DW_AT_sibling, DW_FORM_ref4 }, }, },
+		{ ABBREV_CALL_SITE_PARAMETER, DW_TAG_GNU_call_site_parameter, false, { { DW_AT_location, DW_FORM_exprloc },
+			{ DW_AT_GNU_call_site_value, DW_FORM_exprloc }, }, },
+	};
+	int i, j;
+	for (i = 0; i < sizeof abbreviations / sizeof * abbreviations; i ++)
+	{
+		s.uleb(abbreviations[i].code);
+		s.uleb(abbreviations[i].tag);
+		s.u8(abbreviations[i].has_children ? DW_CHILDREN_yes : DW_CHILDREN_no);
+		for (j = 0; j < abbreviations[i].attributes.size(); j ++)
+			s.uleb(abbreviations[i].attributes.at(j).first), s.uleb(abbreviations[i].attributes.at(j).second);
+		s.uleb(0), s.uleb(0);
+	}
+	s.uleb(0);
+}
+
+/* debug information entry references - these are compilation unit relative, and may refer to entries
+ * that have not yet been written; such references are patched when the compilation unit is complete */
+struct DieReferences
+{
+	std::vector<uint32_t>				labels;
+	std::vector<std::pair<uint32_t, int> >		fixups;
+	uint32_t					compilation_unit_offset;
+	void reset(uint32_t compilation_unit_offset) { labels.clear(), fixups.clear(), this->compilation_unit_offset = compilation_unit_offset; }
+	int label(void) { labels.push_back(-1); return labels.size() - 1; }
+	void define(int label, const ByteStream & s) { labels.at(label) = s.size() - compilation_unit_offset; }
+	void reference(int label, ByteStream & s) { fixups.push_back(std::pair<uint32_t, int>(s.size(), label)); s.u32(0); }
+	void resolve(ByteStream & s)
+	{
+		int i;
+		for (i = 0; i < fixups.size(); i ++)
+		{
+			if (labels.at(fixups.at(i).second) == -1)
+				panic("internal error - undefined debug information entry reference");
+			s.patch32(fixups.at(i).first, labels.at(fixups.at(i).second));
+		}
+	}
+};
+
+struct Options
+{
+	int		cus, dies_per_cu, struct_depth, inlined, loclists, line_rows;
+	const char	* output;
+	Options(void) { cus = 16, dies_per_cu = 256, struct_depth = 4, inlined = 2, loclists = 1, line_rows = 16, output = 0; }
+};
+
+class DwarfGenerator
+{
+private:
+	enum
+	{
+		TEXT_BASE_ADDRESS	= 0x08000000,
+		DATA_BASE_ADDRESS	= 0x20000000,
+		/* minimum instruction length, and code alignment factor, for thumb code */
+		INSTRUCTION_UNIT	= 2,
+		/* each line number table row covers this many bytes of code */
+		LINE_ROW_SIZE		= 4,
+		/* line number program parameters */
+		LINE_BASE		= -5,
+		LINE_RANGE		= 14,
+		OPCODE_BASE		= 13,
+		/* file numbers in the line number tables */
+		SOURCE_FILE		= 1,
+		HELPERS_FILE		= 2,
+		/* line numbers of the declarations in the generated sources */
+		FIRST_STRUCT_LINE	= 10,
+		FIRST_GLOBAL_LINE	= 5,
+		FIRST_SUBPROGRAM_LINE	= 1000,
+		FIRST_HELPER_LINE	= 10,
+	};
+	const struct Options &	options;
+	ByteStream	text, debug_info, debug_abbrev, debug_line, debug_aranges, debug_loc, debug_ranges, debug_frame;
+	StringTable	debug_str;
+	uint32_t	data_size;
+	int		rows_per_subprogram, parameters_per_subprogram, subprograms_per_cu;
+	int		total_dies, total_subprograms, total_line_rows;
+
+	/* a line number table row */
+	struct LineRow { uint32_t address; int file, line; };
+
+	uint32_t subprogramSize(void) { return rows_per_subprogram * LINE_ROW_SIZE; }
+	/* code layout of a subprogram, in line number table rows:
+	 *	rows [0; 2)					- prologue
+	 *	rows [2; 4), [rows - 4; rows - 2)		- a lexical block, described by a range list
+	 *	rows [4 + 2 * i; 6 + 2 * i)			- inlined subroutine number 'i'
+	 *	row rows - 2					- return address of a call
+	 *	row rows - 1					- epilogue */
+	uint32_t inlinedSubroutineAddress(uint32_t subprogram_address, int i) { return subprogram_address + (4 + 2 * i) * LINE_ROW_SIZE; }
+
+	void writeText(uint32_t subprogram_address)
+	{
+		uint32_t i;
+		if (text.size() != subprogram_address - TEXT_BASE_ADDRESS)
+			panic("internal error - text section out of sync");
+		/* push {r7, lr} */
+		text.u16(0xb580);
+		for (i = 1; i < subprogramSize() / 2 - 1; i ++)
+			/* nop */
+			text.u16(0xbf00);
+		/* pop {r7, pc} */
+		text.u16(0xbd80);
+	}
+	void writeFrameDescription(uint32_t subprogram_address)
+	{
+		uint32_t start(debug_frame.size());
+		/* length, patched below */
+		debug_frame.u32(0);
+		/* cie pointer - there is a single cie, at offset zero */
+		debug_frame.u32(0);
+		debug_frame.u32(subprogram_address);
+		debug_frame.u32(subprogramSize());
+		/* after the 'push {r7, lr}' instruction, the cfa is at sp + 8, the return address is saved at
+		 * cfa - 4, and r7 is saved at cfa - 8 */
+		debug_frame.u8(DW_CFA_advance_loc | (2 / INSTRUCTION_UNIT));
+		debug_frame.u8(DW_CFA_def_cfa_offset), debug_frame.uleb(8);
+		debug_frame.u8(DW_CFA_offset | 14), debug_frame.uleb(1);
+		debug_frame.u8(DW_CFA_offset | 7), debug_frame.uleb(2);
+		debug_frame.align(4, DW_CFA_nop);
+		debug_frame.patch32(start, debug_frame.size() - start - sizeof(uint32_t));
+	}
+	void writeCommonInformationEntry(void)
+	{
+		debug_frame.u32(0);
+		debug_frame.u32(0xffffffff);
+		/* version */
+		debug_frame.u8(1);
+		/* augmentation */
+		debug_frame.str("");
+		debug_frame.uleb(INSTRUCTION_UNIT);
+		debug_frame.sleb(-4);
+		/* return address register - lr */
+		debug_frame.u8(14);
+		/* the cfa is the stack pointer at function entry */
+		debug_frame.u8(DW_CFA_def_cfa), debug_frame.uleb(13), debug_frame.uleb(0);
+		debug_frame.align(4, DW_CFA_nop);
+		debug_frame.patch32(0, debug_frame.size() - sizeof(uint32_t));
+	}
+
+	void writeLineNumberProgram(const char * source_file_name, const std::vector<struct LineRow> & rows, uint32_t end_address)
+	{
+		uint32_t start(debug_line.size()), header_length_offset, address;
+		int file, line, i;
+		static const uint8_t standard_opcode_lengths[OPCODE_BASE - 1] = { 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1, };
+
+		/* unit length, patched below */
+		debug_line.u32(0);
+		debug_line.u16(2);
+		/* header length, patched below */
+		header_length_offset = debug_line.size();
+		debug_line.u32(0);
+		debug_line.u8(INSTRUCTION_UNIT);
+		/* default_is_stmt */
+		debug_line.u8(1);
+		debug_line.u8(LINE_BASE);
+		debug_line.u8(LINE_RANGE);
+		debug_line.u8(OPCODE_BASE);
+		for (i = 0; i < OPCODE_BASE - 1; i ++)
+			debug_line.u8(standard_opcode_lengths[i]);
+		/* include directories */
+		debug_line.str("include");
+		debug_line.u8(0);
+		/* file names - name, directory index, modification time, file length */
+		debug_line.str(source_file_name), debug_line.uleb(0), debug_line.uleb(0), debug_line.uleb(0);
+		debug_line.str("helpers.h"), debug_line.uleb(1), debug_line.uleb(0), debug_line.uleb(0);
+		debug_line.u8(0);
+		debug_line.patch32(header_length_offset, debug_line.size() - header_length_offset - sizeof(uint32_t));
+
+		if (rows.size())
+		{
+			address = rows.at(0).address, file = SOURCE_FILE, line = 1;
+			debug_line.u8(0), debug_line.uleb(1 + sizeof(uint32_t)), debug_line.u8(DW_LNE_set_address), debug_line.u32(address);
+			for (i = 0; i < rows.size(); i ++)
+			{
+				int line_advance(rows.at(i).line - line), address_advance((rows.at(i).address - address) / INSTRUCTION_UNIT), opcode;
+				if (rows.at(i).file != file)
+					debug_line.u8(DW_LNS_set_file), debug_line.uleb(file = rows.at(i).file);
+				if (line_advance < LINE_BASE || line_advance >= LINE_BASE + LINE_RANGE)
+					debug_line.u8(DW_LNS_advance_line), debug_line.sleb(line_advance), line_advance = 0;
+				opcode = line_advance - LINE_BASE + LINE_RANGE * address_advance + OPCODE_BASE;
+				if (opcode > 255)
+				{
+					debug_line.u8(DW_LNS_advance_pc), debug_line.uleb(address_advance);
+					opcode = line_advance - LINE_BASE + OPCODE_BASE;
+				}
+				/* special opcode - appends a row to the line number table */
+				debug_line.u8(opcode);
+				address = rows.at(i).address, line = rows.at(i).line;
+			}
+			debug_line.u8(DW_LNS_advance_pc), debug_line.uleb((end_address - address) / INSTRUCTION_UNIT);
+			debug_line.u8(0), debug_line.uleb(1), debug_line.u8(DW_LNE_end_sequence);
+		}
+		debug_line.patch32(start, debug_line.size() - start - sizeof(uint32_t));
+	}
+
+	void writeCompilationUnit(int cu_number)
+	{
+		struct DieReferences refs;
+		ByteStream & s(debug_info);
+		uint32_t cu_offset(s.size()), cu_low_pc(TEXT_BASE_ADDRESS + text.size()), cu_high_pc(cu_low_pc + subprograms_per_cu * subprogramSize());
+		std::string cu_prefix("cu" + std::to_string(cu_number) + "_");
+		std::vector<struct LineRow> line_rows;
+		int i, j, depth, dies(0);
+
+		refs.reset(cu_offset);
+		/* compilation unit header - unit length (patched below), version, abbreviation table offset, address size */
+		s.u32(0), s.u16(4), s.u32(0), s.u8(sizeof(uint32_t));
+
+		std::string source_file_name(cu_prefix + "source.c");
+		s.uleb(ABBREV_COMPILE_UNIT), dies ++;
+		s.u32(debug_str.offset("troll dwarf-generator")), s.u8(DW_LANG_C99), s.u32(debug_str.offset(source_file_name)),
+			s.u32(debug_str.offset("/synthetic")), s.u32(cu_low_pc), s.u32(cu_high_pc - cu_low_pc), s.u32(debug_line.size());
+
+		/* base types */
+		int int_type(refs.label()), unsigned_char_type(refs.label()), unsigned_int_type(refs.label());
+		refs.define(int_type, s), dies ++;
+		s.uleb(ABBREV_BASE_TYPE), s.u32(debug_str.offset("int")), s.u8(DW_ATE_signed), s.u8(4);
+		refs.define(unsigned_char_type, s), dies ++;
+		s.uleb(ABBREV_BASE_TYPE), s.u32(debug_str.offset("unsigned char")), s.u8(DW_ATE_unsigned_char), s.u8(1);
+		refs.define(unsigned_int_type, s), dies ++;
+		s.uleb(ABBREV_BASE_TYPE), s.u32(debug_str.offset("unsigned int")), s.u8(DW_ATE_unsigned), s.u8(4);
+
+		/* unsigned char [8] */
+		int array_type(refs.label()), array_sibling(refs.label());
+		refs.define(array_type, s), dies ++;
+		s.uleb(ABBREV_ARRAY_TYPE), refs.reference(unsigned_char_type, s), refs.reference(array_sibling, s);
+		s.uleb(ABBREV_SUBRANGE_TYPE), dies ++, refs.reference(unsigned_int_type, s), s.u8(7);
+		s.u8(0);
+		refs.define(array_sibling, s);
+
+		/* a chain of nested structure types - each level contains an integer, the next level of the chain,
+		 * a pointer to itself, and an array:
+		 *	struct level { int value; struct level + 1 inner; struct level * self; unsigned char bytes[8]; };
+		 * the innermost level has no 'inner' member */
+		std::vector<int> struct_types, pointer_types;
+		std::vector<uint32_t> struct_sizes(options.struct_depth);
+		for (depth = options.struct_depth - 1; depth >= 0; depth --)
+			struct_sizes.at(depth) = 4 + (depth == options.struct_depth - 1 ? 0 : struct_sizes.at(depth + 1)) + 4 + 8;
+		for (depth = 0; depth < options.struct_depth; depth ++)
+			struct_types.push_back(refs.label()), pointer_types.push_back(refs.label());
+		for (depth = 0; depth < options.struct_depth; depth ++)
+		{
+			int sibling(refs.label()), line(FIRST_STRUCT_LINE + depth * 10);
+			uint32_t member_offset(0);
+			refs.define(struct_types.at(depth), s), dies ++;
+			s.uleb(ABBREV_STRUCTURE_TYPE), s.u32(debug_str.offset(cu_prefix + "level" + std::to_string(depth))), s.u16(struct_sizes.at(depth)),
+				s.u8(SOURCE_FILE), s.u16(line), refs.reference(sibling, s);
+			s.uleb(ABBREV_MEMBER), dies ++, s.u32(debug_str.offset("value")), s.u8(SOURCE_FILE), s.u16(++ line), refs.reference(int_type, s), s.u16(member_offset);
+			member_offset += 4;
+			if (depth != options.struct_depth - 1)
+			{
+				s.uleb(ABBREV_MEMBER), dies ++, s.u32(debug_str.offset("inner")), s.u8(SOURCE_FILE), s.u16(++ line), refs.reference(struct_types.at(depth + 1), s), s.u16(member_offset);
+				member_offset += struct_sizes.at(depth + 1);
+			}
+			s.uleb(ABBREV_MEMBER), dies ++, s.u32(debug_str.offset("self")), s.u8(SOURCE_FILE), s.u16(++ line), refs.reference(pointer_types.at(depth), s), s.u16(member_offset);
+			member_offset += 4;
+			s.uleb(ABBREV_MEMBER), dies ++, s.u32(debug_str.offset("bytes")), s.u8(SOURCE_FILE), s.u16(++ line), refs.reference(array_type, s), s.u16(member_offset);
+			s.u8(0);
+			refs.define(sibling, s);
+			refs.define(pointer_types.at(depth), s), dies ++;
+			s.uleb(ABBREV_POINTER_TYPE), s.u8(4), refs.reference(struct_types.at(depth), s);
+		}
+
+		/* global variables - an instance of the outermost structure, and a counter */
+		int outermost_type(options.struct_depth ? struct_types.at(0) : int_type);
+		uint32_t outermost_size(options.struct_depth ? struct_sizes.at(0) : 4);
+		s.uleb(ABBREV_GLOBAL_VARIABLE), dies ++, s.u32(debug_str.offset(cu_prefix + "state")), s.u8(SOURCE_FILE), s.u16(FIRST_GLOBAL_LINE),
+			refs.reference(outermost_type, s), s.uleb(1 + sizeof(uint32_t)), s.u8(DW_OP_addr), s.u32(DATA_BASE_ADDRESS + data_size);
+		data_size += (outermost_size + 3) & ~3;
+		s.uleb(ABBREV_GLOBAL_VARIABLE), dies ++, s.u32(debug_str.offset(cu_prefix + "counter")), s.u8(SOURCE_FILE), s.u16(FIRST_GLOBAL_LINE + 1),
+			refs.reference(int_type, s), s.uleb(1 + sizeof(uint32_t)), s.u8(DW_OP_addr), s.u32(DATA_BASE_ADDRESS + data_size);
+		data_size += 4;
+
+		/* abstract instances of the inlined subroutines, declared in the 'helpers.h' file */
+		std::vector<int> helpers, helper_parameters;
+		for (i = 0; i < options.inlined; i ++)
+		{
+			int sibling(refs.label());
+			helpers.push_back(refs.label()), helper_parameters.push_back(refs.label());
+			refs.define(helpers.at(i), s), dies ++;
+			s.uleb(ABBREV_ABSTRACT_SUBPROGRAM), s.u32(debug_str.offset("helper" + std::to_string(i))), s.u8(HELPERS_FILE), s.u16(FIRST_HELPER_LINE + i * 10),
+				refs.reference(int_type, s), s.u8(DW_INL_declared_inlined), refs.reference(sibling, s);
+			refs.define(helper_parameters.at(i), s), dies ++;
+			s.uleb(ABBREV_ABSTRACT_PARAMETER), s.u32(debug_str.offset("x")), s.u8(HELPERS_FILE), s.u16(FIRST_HELPER_LINE + i * 10), refs.reference(int_type, s);
+			s.u8(0);
+			refs.define(sibling, s);
+		}
+
+		/* subprograms */
+		std::vector<int> subprograms;
+		for (i = 0; i < subprograms_per_cu; i ++)
+			subprograms.push_back(refs.label());
+		for (i = 0; i < subprograms_per_cu; i ++)
+		{
+			uint32_t address(TEXT_BASE_ADDRESS + text.size()), cu_relative_address(address - cu_low_pc);
+			int sibling(refs.label()), line(FIRST_SUBPROGRAM_LINE + i * (rows_per_subprogram + 4)), row;
+
+			writeText(address);
+			writeFrameDescription(address);
+			for (row = 0; row < rows_per_subprogram; row ++)
+			{
+				struct LineRow r = { address + row * LINE_ROW_SIZE, SOURCE_FILE, line + row, };
+				j = row / 2 - 2;
+				if (4 <= row && j < options.inlined)
+					r.file = HELPERS_FILE, r.line = FIRST_HELPER_LINE + j * 10 + 1 + (row & 1);
+				line_rows.push_back(r);
+			}
+
+			refs.define(subprograms.at(i), s), dies ++;
+			s.uleb(ABBREV_SUBPROGRAM), s.u32(debug_str.offset(cu_prefix + "function" + std::to_string(i))), s.u8(SOURCE_FILE), s.u32(line),
+				refs.reference(int_type, s), s.u32(address), s.u32(subprogramSize());
+			s.uleb(1), s.u8(DW_OP_call_frame_cfa);
+			refs.reference(sibling, s);
+
+			/* parameters - the first ones are described by location lists, the rest are on the stack */
+			for (j = 0; j < parameters_per_subprogram; j ++)
+			{
+				uint32_t name(debug_str.offset("parameter" + std::to_string(j)));
+				int32_t frame_offset(-12 - 4 * j);
+				ByteStream stack_slot;
+				stack_slot.u8(DW_OP_fbreg), stack_slot.sleb(frame_offset);
+				dies ++;
+				if (j < options.loclists)
+				{
+					s.uleb(ABBREV_LOCATION_LIST_PARAMETER), s.u32(name), s.u8(SOURCE_FILE), s.u32(line), refs.reference(int_type, s), s.u32(debug_loc.size());
+					/* in a register up to the end of the prologue, and in its stack slot after that */
+					debug_loc.u32(cu_relative_address), debug_loc.u32(cu_relative_address + 2 * LINE_ROW_SIZE);
+					debug_loc.u16(1), debug_loc.u8(DW_OP_reg0 + j % 4);
+					debug_loc.u32(cu_relative_address + 2 * LINE_ROW_SIZE), debug_loc.u32(cu_relative_address + subprogramSize());
+					debug_loc.u16(stack_slot.size()), debug_loc.append(stack_slot);
+					debug_loc.u32(0), debug_loc.u32(0);
+				}
+				else
+				{
+					s.uleb(ABBREV_PARAMETER), s.u32(name), s.u8(SOURCE_FILE), s.u32(line), refs.reference(int_type, s);
+					s.uleb(stack_slot.size()), s.append(stack_slot);
+				}
+			}
+			/* a local pointer to the global structure instance */
+			s.uleb(ABBREV_VARIABLE), dies ++, s.u32(debug_str.offset("p")), s.u8(SOURCE_FILE), s.u32(line + 1),
+				refs.reference(options.struct_depth ? pointer_types.at(0) : int_type, s);
+			s.uleb(2), s.u8(DW_OP_fbreg), s.sleb(-8);
+
+			/* a lexical block, covering two disjoint address ranges */
+			int block_sibling(refs.label());
+			s.uleb(ABBREV_LEXICAL_BLOCK), dies ++, s.u32(debug_ranges.size()), refs.reference(block_sibling, s);
+			debug_ranges.u32(cu_relative_address + 2 * LINE_ROW_SIZE), debug_ranges.u32(cu_relative_address + 4 * LINE_ROW_SIZE);
+			debug_ranges.u32(cu_relative_address + subprogramSize() - 4 * LINE_ROW_SIZE), debug_ranges.u32(cu_relative_address + subprogramSize() - 2 * LINE_ROW_SIZE);
+			debug_ranges.u32(0), debug_ranges.u32(0);
+			s.uleb(ABBREV_VARIABLE), dies ++, s.u32(debug_str.offset("i")), s.u8(SOURCE_FILE), s.u32(line + 2), refs.reference(unsigned_int_type, s);
+			s.uleb(2), s.u8(DW_OP_fbreg), s.sleb(-4);
+			s.u8(0);
+			refs.define(block_sibling, s);
+
+			/* inlined subroutines */
+			for (j = 0; j < options.inlined; j ++)
+			{
+				int inlined_sibling(refs.label());
+				s.uleb(ABBREV_INLINED_SUBROUTINE), dies ++, refs.reference(helpers.at(j), s), s.u32(inlinedSubroutineAddress(address, j)), s.u32(2 * LINE_ROW_SIZE),
+					s.u8(SOURCE_FILE), s.u32(line + 4 + 2 * j), refs.reference(inlined_sibling, s);
+				s.uleb(ABBREV_INLINED_PARAMETER), dies ++, refs.reference(helper_parameters.at(j), s), s.uleb(1), s.u8(DW_OP_reg0 + j % 4);
+				s.u8(0);
+				refs.define(inlined_sibling, s);
+			}
+
+			/* a call to the next subprogram in the compilation unit, passing a constant in r0 */
+			int call_site_sibling(refs.label());
+			s.uleb(ABBREV_CALL_SITE), dies ++, s.u32(address + subprogramSize() - 2 * LINE_ROW_SIZE),
+				refs.reference(subprograms.at((i + 1) % subprograms_per_cu), s), refs.reference(call_site_sibling, s);
+			s.uleb(ABBREV_CALL_SITE_PARAMETER), dies ++, s.uleb(1), s.u8(DW_OP_reg0), s.uleb(1), s.u8(DW_OP_lit0 + i % 32);
+			s.u8(0);
+			refs.define(call_site_sibling, s);
+
+			s.u8(0);
+			refs.define(sibling, s);
+		}
+		/* end of the compilation unit die children */
+		s.u8(0);
+		refs.resolve(s);
+		s.patch32(cu_offset, s.size() - cu_offset - sizeof(uint32_t));
+
+		writeLineNumberProgram(source_file_name.c_str(), line_rows, cu_high_pc);
+
+		/* address ranges - header, padding so that the address ranges are aligned on a multiple of twice
+		 * the address size, a single range for the compilation unit, and the terminating entry */
+		debug_aranges.u32(28), debug_aranges.u16(2), debug_aranges.u32(cu_offset), debug_aranges.u8(sizeof(uint32_t)), debug_aranges.u8(0);
+		debug_aranges.u32(0);
+		debug_aranges.u32(cu_low_pc), debug_aranges.u32(cu_high_pc - cu_low_pc);
+		debug_aranges.u32(0), debug_aranges.u32(0);
+
+		total_dies += dies, total_subprograms += subprograms_per_cu, total_line_rows += line_rows.size();
+	}
+
+	/* returns the number of debug information entries in a compilation unit, that are not part of a subprogram */
+	int fixedDieCount(void)
+	{
+		return /* compilation unit */ 1 + /* base types */ 3 + /* array type */ 2 + /* structures */ options.struct_depth * 6 - (options.struct_depth ? 1 : 0)
+			+ /* global variables */ 2 + /* abstract inline subprograms */ 2 * options.inlined;
+	}
+	/* returns the number of debug information entries for a subprogram */
+	int subprogramDieCount(void)
+	{
+		return /* subprogram */ 1 + parameters_per_subprogram + /* local variable */ 1 + /* lexical block */ 2
+			+ /* inlined subroutines */ 2 * options.inlined + /* call site */ 2;
+	}
+
+public:
+	DwarfGenerator(const struct Options & options) : options(options)
+	{
+		data_size = total_dies = total_subprograms = total_line_rows = 0;
+		rows_per_subprogram = std::max(options.line_rows, 8 + 2 * options.inlined);
+		parameters_per_subprogram = std::max(options.loclists, 2);
+		subprograms_per_cu = std::max((options.dies_per_cu - fixedDieCount()) / subprogramDieCount(), 1);
+	}
+	void generate(void)
+	{
+		int i;
+		writeAbbreviations(debug_abbrev);
+		writeCommonInformationEntry();
+		for (i = 0; i < options.cus; i ++)
+			writeCompilationUnit(i);
+	}
+	/* writes the elf file; returns false on error */
+	bool write(const char * elf_filename);
+	void printSummary(void)
+	{
+		fprintf(stderr, "%d compilation units, %d debug information entries, %d subprograms, %d line number table rows\n",
+			options.cus, total_dies, total_subprograms, total_line_rows);
+		fprintf(stderr, ".text %u bytes, .debug_info %u bytes, .debug_line %u bytes, .debug_loc %u bytes, .debug_frame %u bytes, .debug_str %u bytes\n",
+			text.size(), debug_info.size(), debug_line.size(), debug_loc.size(), debug_frame.size(), debug_str.s.size());
+	}
+};
+
+bool DwarfGenerator::write(const char * elf_filename)
+{
+	enum
+	{
+		ELF_HEADER_SIZE		= 52,
+		PROGRAM_HEADER_SIZE	= 32,
+		SECTION_HEADER_SIZE	= 40,
+		EM_ARM			= 40,
+		EF_ARM_EABI_VER5	= 0x05000000,
+		ET_EXEC			= 2,
+		PT_LOAD			= 1,
+		PF_X			= 1,
+		PF_R			= 4,
+		SHT_PROGBITS		= 1,
+		SHT_STRTAB		= 3,
+		SHT_NOBITS		= 8,
+		SHF_WRITE		= 1,
+		SHF_ALLOC		= 2,
+		SHF_EXECINSTR		= 4,
+	};
+	struct Section { const char * name; uint32_t type, flags, address, alignment; const ByteStream * contents; uint32_t size, name_offset, file_offset; };
+	ByteStream section_names, elf;
+	std::vector<struct Section> sections =
+	{
+		{ "", 0, 0, 0, 0, 0, },
+		{ ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, TEXT_BASE_ADDRESS, 4, & text, },
+		{ ".bss", SHT_NOBITS, SHF_ALLOC | SHF_WRITE, DATA_BASE_ADDRESS, 4, 0, },
+		{ ".debug_aranges", SHT_PROGBITS, 0, 0, 1, & debug_aranges, },
+		{ ".debug_info", SHT_PROGBITS, 0, 0, 1, & debug_info, },
+		{ ".debug_abbrev", SHT_PROGBITS, 0, 0, 1, & debug_abbrev, },
+		{ ".debug_line", SHT_PROGBITS, 0, 0, 1, & debug_line, },
+		{ ".debug_frame", SHT_PROGBITS, 0, 0, 4, & debug_frame, },
+		{ ".debug_str", SHT_PROGBITS, 0, 0, 1, & debug_str.s, },
+		{ ".debug_loc", SHT_PROGBITS, 0, 0, 1, & debug_loc, },
+		{ ".debug_ranges", SHT_PROGBITS, 0, 0, 1, & debug_ranges, },
+		{ ".shstrtab", SHT_STRTAB, 0, 0, 1, & section_names, },
+	};
+	int i;
+
+	for (i = 0; i < sections.size(); i ++)
+		sections.at(i).name_offset = section_names.size(), section_names.str(sections.at(i).name);
+	sections.at(2).size = data_size;
+
+	/* lay out the file - elf header, program header, section contents, section headers */
+	uint32_t offset(ELF_HEADER_SIZE + PROGRAM_HEADER_SIZE);
+	for (i = 1; i < sections.size(); i ++)
+	{
+		if (sections.at(i).contents)
+			sections.at(i).size = sections.at(i).contents->size();
+		offset = (offset + 3) & ~3;
+		sections.at(i).file_offset = offset;
+		if (sections.at(i).type != SHT_NOBITS)
+			offset += sections.at(i).size;
+	}
+	uint32_t section_headers_offset((offset + 3) & ~3);
+
+	/* elf header */
+	elf.u8(0x7f), elf.u8('E'), elf.u8('L'), elf.u8('F');
+	/* 32 bit, little-endian, current version, system v abi */
+	elf.u8(1), elf.u8(1), elf.u8(1), elf.u8(0);
+	while (elf.size() < 16)
+		elf.u8(0);
+	elf.u16(ET_EXEC), elf.u16(EM_ARM), elf.u32(1);
+	/* entry point - the first subprogram, in thumb state */
+	elf.u32(TEXT_BASE_ADDRESS | 1);
+	elf.u32(ELF_HEADER_SIZE), elf.u32(section_headers_offset), elf.u32(EF_ARM_EABI_VER5);
+	elf.u16(ELF_HEADER_SIZE), elf.u16(PROGRAM_HEADER_SIZE), elf.u16(1), elf.u16(SECTION_HEADER_SIZE), elf.u16(sections.size()), elf.u16(sections.size() - 1);
+
+	/* a single loadable segment, for the code */
+	elf.u32(PT_LOAD), elf.u32(sections.at(1).file_offset), elf.u32(TEXT_BASE_ADDRESS), elf.u32(TEXT_BASE_ADDRESS),
+		elf.u32(text.size()), elf.u32(text.size()), elf.u32(PF_R | PF_X), elf.u32(4);
+
+	for (i = 1; i < sections.size(); i ++)
+	{
+		elf.align(4);
+		if (elf.size() != sections.at(i).file_offset)
+			panic("internal error - elf file layout out of sync");
+		if (sections.at(i).contents)
+			elf.append(* sections.at(i).contents);
+	}
+	elf.align(4);
+	for (i = 0; i < sections.size(); i ++)
+	{
+		const struct Section & x(sections.at(i));
+		elf.u32(x.name_offset), elf.u32(x.type), elf.u32(x.flags), elf.u32(x.address), elf.u32(i ? x.file_offset : 0), elf.u32(x.size);
+		/* link, info, alignment, entry size */
+		elf.u32(0), elf.u32(0), elf.u32(x.alignment), elf.u32(0);
+	}
+
+	FILE * f = fopen(elf_filename, "wb");
+	if (!f)
+		return false;
+	bool result(fwrite(elf.bytes.data(), 1, elf.size(), f) == elf.size());
+	return (fclose(f) == 0) && result;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: dwarf-generator [--cus=n] [--dies-per-cu=n] [--struct-depth=n] [--inlined=n] [--loclists=n] [--line-rows=n] -o elf-file\n");
+	exit(1);
+}
+
+int main(int argc, char * argv[])
+{
+	struct Options options;
+	struct { const char * name; int * value; } numeric_options[] =
+	{
+		{ "--cus=", & options.cus, },
+		{ "--dies-per-cu=", & options.dies_per_cu, },
+		{ "--struct-depth=", & options.struct_depth, },
+		{ "--inlined=", & options.inlined, },
+		{ "--loclists=", & options.loclists, },
+		{ "--line-rows=", & options.line_rows, },
+	};
+	int i, j;
+
+	for (i = 1; i < argc; i ++)
+	{
+		if (!strcmp(argv[i], "-o") && i + 1 < argc)
+		{
+			options.output = argv[++ i];
+			continue;
+		}
+		for (j = 0; j < sizeof numeric_options / sizeof * numeric_options; j ++)
+			if (!strncmp(argv[i], numeric_options[j].name, strlen(numeric_options[j].name)))
+			{
+				char * end;
+				long x = strtol(argv[i] + strlen(numeric_options[j].name), & end, 0);
+				if (* end || x < 0 || x > 1000000)
+					usage();
+				* numeric_options[j].value = x;
+				break;
+			}
+		if (j == sizeof numeric_options / sizeof * numeric_options)
+			usage();
+	}
+	if (!options.output || !options.cus)
+		usage();
+	/* keep the structure sizes within the range of the 'DW_FORM_data2' encoding used for them */
+	if (options.struct_depth > 1000)
+		panic("structure nesting depth too large");
+
+	DwarfGenerator generator(options);
+	generator.generate();
+	if (!generator.write(options.output))
+		panic("cannot write output file");
+	generator.printSummary();
+	return 0;
+}
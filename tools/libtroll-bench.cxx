@@ -0,0 +1,379 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* libtroll micro-benchmark - times the dwarf engine queries against a given elf file, outside of the troll gui
+ *
+ * usage: libtroll-bench elf-file [query-iterations [constructor-iterations]]
+ *
+ * the results are printed to stdout, one json object per line, per benchmark; the times are in nanoseconds,
+ * and the allocation counts are the number of calls to the global operator new, per benchmark iteration */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <map>
+#include "debug-sections.hxx"
+
+static unsigned long long allocation_count, allocated_bytes;
+
+void * operator new(size_t size)
+{
+	void * p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	allocation_count ++, allocated_bytes += size;
+	return p;
+}
+void * operator new[](size_t size) { return operator new(size); }
+void operator delete(void * p) noexcept { free(p); }
+void operator delete[](void * p) noexcept { free(p); }
+void operator delete(void * p, size_t) noexcept { free(p); }
+void operator delete[](void * p, size_t) noexcept { free(p); }
+
+/* reference leb128 decoders - straightforward byte by byte loops, the way libtroll used to decode leb128 numbers;
+ * the leb128 benchmarks below compare these against the libtroll decoders */
+static uint32_t referenceUleb128(const uint8_t * data, int * decoded_len)
+{
+	uint64_t result = 0;
+	uint8_t x;
+	int shift = * decoded_len = 0;
+	do x = * data ++, result |= ((uint64_t) (x & 0x7f) << shift), shift += 7, (* decoded_len) ++; while (x & 0x80);
+	return result;
+}
+static int32_t referenceSleb128(const uint8_t * data, int * decoded_len)
+{
+	uint64_t result = 0;
+	uint8_t x;
+	int shift = * decoded_len = 0;
+	do x = * data ++, result |= ((uint64_t) (x & 0x7f) << shift), shift += 7, (* decoded_len) ++; while (x & 0x80);
+	if (x & 0x40)
+		result |= - (uint64_t) 1 << (shift - 1);
+	return result;
+}
+
+/* reference attribute data size computation - a plain switch over all forms, with the reference leb128 decoders,
+ * the way libtroll used to skip attribute data */
+static int referenceFormSize(uint32_t form, const uint8_t * data)
+{
+	int len;
+	switch (form)
+	{
+		default:
+			fprintf(stderr, "error: unsupported attribute form $%x\n", form);
+			exit(1);
+		case DW_FORM_addr: case DW_FORM_data4: case DW_FORM_strp: case DW_FORM_ref_addr: case DW_FORM_ref4: case DW_FORM_sec_offset:
+			return 4;
+		case DW_FORM_data2: case DW_FORM_ref2:
+			return 2;
+		case DW_FORM_data1: case DW_FORM_flag: case DW_FORM_ref1:
+			return 1;
+		case DW_FORM_data8: case DW_FORM_ref8: case DW_FORM_ref_sig8:
+			return 8;
+		case DW_FORM_flag_present:
+			return 0;
+		case DW_FORM_block1:
+			return 1 + * data;
+		case DW_FORM_block2:
+			return 2 + * (const uint16_t *) data;
+		case DW_FORM_block4:
+			return 4 + * (const uint32_t *) data;
+		case DW_FORM_block: case DW_FORM_exprloc:
+			return referenceUleb128(data, & len) + len;
+		case DW_FORM_string:
+			return strlen((const char *) data) + 1;
+		case DW_FORM_udata: case DW_FORM_ref_udata:
+			return referenceUleb128(data, & len), len;
+		case DW_FORM_sdata:
+			return referenceSleb128(data, & len), len;
+	}
+}
+
+/* skips all dies in .debug_info the way libtroll used to - the abbreviations of each compilation unit are kept in a map,
+ * and the attributes of each die are skipped one by one, with the reference leb128 decoders; if 'uleb128_numbers' and
+ * 'sleb128_numbers' are not null, pointers to all unsigned (abbreviation codes, 'udata' and 'ref_udata' forms) and
+ * signed ('sdata' forms) leb128 numbers in .debug_info are collected in them; returns the number of dies */
+static int referenceSkipDies(const uint8_t * debug_info, uint32_t debug_info_len, const uint8_t * debug_abbrev,
+	std::vector<const uint8_t *> * uleb128_numbers = 0, std::vector<const uint8_t *> * sleb128_numbers = 0)
+{
+	std::map<uint32_t, const uint8_t *> abbreviations;
+	const uint8_t * cu, * die, * cu_end, * p;
+	uint32_t code, name, form;
+	int len, dies = 0;
+	for (cu = debug_info; cu < debug_info + debug_info_len; cu = cu_end)
+	{
+		cu_end = cu + sizeof(uint32_t) + * (const uint32_t *) cu;
+		abbreviations.clear();
+		for (p = debug_abbrev + * (const uint32_t *) (cu + 6); (code = referenceUleb128(p, & len)); )
+		{
+			abbreviations[code] = p;
+			/* skip the abbreviation code, tag, children flag, and attribute specifications */
+			p += len, referenceUleb128(p, & len), p += len, referenceUleb128(p, & len), p += len;
+			do name = referenceUleb128(p, & len), p += len, form = referenceUleb128(p, & len), p += len; while (name || form);
+		}
+		for (die = cu + /* skip compilation unit header */ 11; die < cu_end; )
+		{
+			if (uleb128_numbers)
+				uleb128_numbers->push_back(die);
+			code = referenceUleb128(die, & len), die += len;
+			if (!code)
+				continue;
+			dies ++;
+			p = abbreviations.at(code);
+			referenceUleb128(p, & len), p += len, referenceUleb128(p, & len), p += len, referenceUleb128(p, & len), p += len;
+			while (name = referenceUleb128(p, & len), p += len, form = referenceUleb128(p, & len), p += len, name || form)
+			{
+				if (uleb128_numbers && (form == DW_FORM_udata || form == DW_FORM_ref_udata))
+					uleb128_numbers->push_back(die);
+				if (sleb128_numbers && form == DW_FORM_sdata)
+					sleb128_numbers->push_back(die);
+				die += referenceFormSize(form, die);
+			}
+		}
+	}
+	return dies;
+}
+
+/* skips all dies in .debug_info the way libtroll does now - with the libtroll leb128 decoders and attribute skipping, and
+ * skipping the attributes of abbreviations which only have fixed size forms with a single addition; returns the number of dies */
+static int skipDies(const uint8_t * debug_info, uint32_t debug_info_len, const uint8_t * debug_abbrev)
+{
+	std::map<uint32_t, std::pair<const uint8_t * /* abbreviation */, int /* attribute data size, or -1 */> > abbreviations;
+	const uint8_t * cu, * die, * cu_end, * p;
+	uint32_t code, name, form;
+	int len, dies = 0, data_size, form_size;
+	for (cu = debug_info; cu < debug_info + debug_info_len; cu = cu_end)
+	{
+		cu_end = cu + sizeof(uint32_t) + * (const uint32_t *) cu;
+		abbreviations.clear();
+		for (p = debug_abbrev + * (const uint32_t *) (cu + 6); (code = DwarfUtil::uleb128(p, & len)); )
+		{
+			const uint8_t * abbreviation = p;
+			p += len, DwarfUtil::uleb128x(p), DwarfUtil::uleb128x(p);
+			data_size = 0;
+			while (name = DwarfUtil::uleb128x(p), form = DwarfUtil::uleb128x(p), name || form)
+				if (data_size != -1)
+					data_size = ((form_size = DwarfUtil::fixedFormSize(form)) == -1) ? -1 : data_size + form_size;
+			abbreviations[code] = std::make_pair(abbreviation, data_size);
+		}
+		for (die = cu + /* skip compilation unit header */ 11; die < cu_end; )
+		{
+			if (!(code = DwarfUtil::uleb128x(die)))
+				continue;
+			dies ++;
+			const auto & x = abbreviations.at(code);
+			if (x.second != -1)
+			{
+				die += x.second;
+				continue;
+			}
+			struct Abbreviation a(x.first);
+			for (auto attr = a.next_attribute(); attr.first; attr = a.next_attribute())
+				die += DwarfUtil::skip_form_bytes(attr.second, die);
+		}
+	}
+	return dies;
+}
+
+/* runs 'operation' 'iterations' times, passing it the iteration number, and prints the statistics for the runs */
+static void benchmark(const char * name, int iterations, std::function<void(int)> operation)
+{
+	std::vector<uint64_t> times;
+	unsigned long long allocations, bytes;
+	uint64_t total = 0;
+	int i;
+
+	if (iterations <= 0)
+	{
+		printf("{\"benchmark\": \"%s\", \"iterations\": 0}\n", name);
+		return;
+	}
+	times.reserve(iterations);
+	allocations = allocation_count, bytes = allocated_bytes;
+	for (i = 0; i < iterations; i ++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		operation(i);
+		times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+	allocations = allocation_count - allocations, bytes = allocated_bytes - bytes;
+	std::sort(times.begin(), times.end());
+	for (i = 0; i < times.size(); total += times.at(i ++));
+	auto percentile = [&] (int p) -> uint64_t { return times.at((times.size() - 1) * p / 100); };
+	printf("{\"benchmark\": \"%s\", \"iterations\": %d, \"mean_ns\": %llu, \"min_ns\": %llu, \"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, "
+	       "\"allocations_per_iteration\": %.2f, \"allocated_bytes_per_iteration\": %.2f}\n",
+	       name, iterations, (unsigned long long) (total / iterations), (unsigned long long) times.front(),
+	       (unsigned long long) percentile(50), (unsigned long long) percentile(90), (unsigned long long) percentile(99), (unsigned long long) times.back(),
+	       (double) allocations / iterations, (double) bytes / iterations);
+	fflush(stdout);
+}
+
+int main(int argc, char * argv[])
+{
+	struct DebugSections sections;
+	std::string error;
+	int iterations = 10000, constructor_iterations = 10;
+	int i;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s elf-file [query-iterations [constructor-iterations]]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 2)
+		iterations = atoi(argv[2]);
+	if (argc > 3)
+		constructor_iterations = atoi(argv[3]);
+	if (!(error = sections.load(argv[1])).empty())
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	benchmark("constructor", constructor_iterations, [&] (int) { delete sections.dwarfData(); });
+
+	DwarfData * dwdata = sections.dwarfData();
+	DwarfUnwinder * unwinder = sections.dwarfUnwinder();
+
+	/* collect the benchmark inputs - a sample of the addresses, and source file and line number pairs, in the line number
+	 * tables, and the die offsets of the static data objects; take at most 'max_samples' samples, evenly spread */
+	const int max_samples = 4096;
+	std::vector<struct DebugLine::sourceFileNames> sources;
+	std::vector<struct DebugLine::lineAddress> line_addresses, x;
+	std::vector<const char *> line_address_files;
+	std::vector<uint32_t> addresses;
+	std::vector<std::pair<const char *, uint32_t> > file_lines;
+	std::vector<struct StaticObject> data_objects, subprograms;
+	std::vector<uint32_t> data_object_die_offsets;
+
+	dwdata->getFileAndDirectoryNamesPointers(sources);
+	std::sort(sources.begin(), sources.end(), [] (const struct DebugLine::sourceFileNames & a, const struct DebugLine::sourceFileNames & b) -> bool { return strcmp(a.file, b.file) < 0; });
+	sources.erase(std::unique(sources.begin(), sources.end(), [] (const struct DebugLine::sourceFileNames & a, const struct DebugLine::sourceFileNames & b) -> bool { return !strcmp(a.file, b.file); }), sources.end());
+	for (i = 0; i < sources.size(); i ++)
+	{
+		x.clear();
+		dwdata->addressesForFile(sources.at(i).file, x);
+		line_addresses.insert(line_addresses.end(), x.begin(), x.end());
+		line_address_files.insert(line_address_files.end(), x.size(), sources.at(i).file);
+	}
+	for (i = 0; i < line_addresses.size(); i += (line_addresses.size() + max_samples - 1) / max_samples)
+	{
+		addresses.push_back(line_addresses.at(i).address);
+		file_lines.push_back(std::pair<const char *, uint32_t>(line_address_files.at(i), line_addresses.at(i).line));
+	}
+	dwdata->reapStaticObjects(data_objects, subprograms);
+	for (i = 0; i < data_objects.size(); i += (data_objects.size() + max_samples - 1) / max_samples)
+		data_object_die_offsets.push_back(data_objects.at(i).die_offset);
+
+	fprintf(stderr, "%d source files, %d line table address ranges, %d static data objects, %d subprograms\n",
+		(int) sources.size(), (int) line_addresses.size(), (int) data_objects.size(), (int) subprograms.size());
+
+	benchmark("address-to-compilation-unit", addresses.empty() ? 0 : iterations, [&] (int i)
+		{ dwdata->compilationUnitOffsetForAddress(addresses.at(i % addresses.size())); });
+	benchmark("address-to-line", addresses.empty() ? 0 : iterations, [&] (int i)
+		{ dwdata->sourceCodeCoordinatesForAddress(addresses.at(i % addresses.size())); });
+	benchmark("file-and-line-to-addresses", file_lines.empty() ? 0 : iterations, [&] (int i)
+		{ dwdata->unfilteredAddressesForFileAndLineNumber(file_lines.at(i % file_lines.size()).first, file_lines.at(i % file_lines.size()).second); });
+	benchmark("file-and-line-to-filtered-addresses", file_lines.empty() ? 0 : iterations, [&] (int i)
+		{ dwdata->filteredAddressesForFileAndLineNumber(file_lines.at(i % file_lines.size()).first, file_lines.at(i % file_lines.size()).second); });
+	benchmark("execution-context", addresses.empty() ? 0 : iterations, [&] (int i)
+		{ dwdata->executionContextForAddress(addresses.at(i % addresses.size())); });
+	benchmark("read-type-and-data-for-type", data_object_die_offsets.empty() ? 0 : iterations, [&] (int i)
+		{
+			std::vector<struct DwarfTypeNode> type_cache;
+			struct DwarfData::DataNode node;
+			dwdata->readType(data_object_die_offsets.at(i % data_object_die_offsets.size()), type_cache);
+			dwdata->dataForType(type_cache, node, true, 1);
+		});
+	benchmark("reap-static-objects", constructor_iterations, [&] (int)
+		{
+			std::vector<struct StaticObject> data_objects, subprograms;
+			dwdata->reapStaticObjects(data_objects, subprograms);
+		});
+	/* the leb128 numbers in .debug_info - abbreviation codes, and 'udata', 'ref_udata' and 'sdata' attribute values; decode
+	 * all of them, and check that the reference and libtroll decoders agree */
+	const uint8_t * debug_info = (const uint8_t *) sections.debug_info.data(), * debug_abbrev = (const uint8_t *) sections.debug_abbrev.data();
+	std::vector<const uint8_t *> uleb128_numbers, sleb128_numbers;
+	int die_count = referenceSkipDies(debug_info, sections.debug_info.size(), debug_abbrev, & uleb128_numbers, & sleb128_numbers);
+	fprintf(stderr, "%d dies, %d unsigned and %d signed leb128 numbers in .debug_info\n", die_count, (int) uleb128_numbers.size(), (int) sleb128_numbers.size());
+	uint32_t checksum = 0, reference_checksum = 0;
+	benchmark("uleb128-reference-debug-info", uleb128_numbers.empty() ? 0 : constructor_iterations, [&] (int)
+		{
+			uint32_t sum = 0;
+			int len;
+			for (const uint8_t * p : uleb128_numbers)
+				sum += referenceUleb128(p, & len) + len;
+			reference_checksum = sum;
+		});
+	benchmark("uleb128-debug-info", uleb128_numbers.empty() ? 0 : constructor_iterations, [&] (int)
+		{
+			uint32_t sum = 0;
+			int len;
+			for (const uint8_t * p : uleb128_numbers)
+				sum += DwarfUtil::uleb128(p, & len) + len;
+			checksum = sum;
+		});
+	if (checksum != reference_checksum)
+		fprintf(stderr, "error: uleb128 decoder mismatch\n");
+	checksum = reference_checksum = 0;
+	benchmark("sleb128-reference-debug-info", sleb128_numbers.empty() ? 0 : constructor_iterations, [&] (int)
+		{
+			int32_t sum = 0;
+			int len;
+			for (const uint8_t * p : sleb128_numbers)
+				sum += referenceSleb128(p, & len) + len;
+			reference_checksum = sum;
+		});
+	benchmark("sleb128-debug-info", sleb128_numbers.empty() ? 0 : constructor_iterations, [&] (int)
+		{
+			int32_t sum = 0;
+			int len;
+			for (const uint8_t * p : sleb128_numbers)
+				sum += DwarfUtil::sleb128(p, & len) + len;
+			checksum = sum;
+		});
+	if (checksum != reference_checksum)
+		fprintf(stderr, "error: sleb128 decoder mismatch\n");
+	/* skip all dies in .debug_info, with the reference and with the libtroll die skipping */
+	int reference_dies_skipped = 0, dies_skipped = 0;
+	benchmark("skip-all-dies-reference", constructor_iterations, [&] (int)
+		{ reference_dies_skipped = referenceSkipDies(debug_info, sections.debug_info.size(), debug_abbrev); });
+	benchmark("skip-all-dies", constructor_iterations, [&] (int)
+		{ dies_skipped = skipDies(debug_info, sections.debug_info.size(), debug_abbrev); });
+	if (dies_skipped != reference_dies_skipped)
+		fprintf(stderr, "error: die skipping mismatch\n");
+	/* read the whole die tree of each compilation unit - this mostly exercises the die skipping */
+	benchmark("die-trees-of-all-compilation-units", constructor_iterations, [&] (int)
+		{
+			uint32_t cu, die_offset;
+			for (cu = 0; cu != -1; cu = dwdata->next_compilation_unit(cu))
+				dwdata->debug_tree_of_die(die_offset = cu + /* skip compilation unit header */ 11);
+		});
+	benchmark("cfi-lookup", (addresses.empty() || sections.debug_frame.empty()) ? 0 : iterations, [&] (int i)
+		{ unwinder->sforthCodeForAddress(addresses.at(i % addresses.size())); });
+
+	delete unwinder;
+	delete dwdata;
+	return 0;
+}
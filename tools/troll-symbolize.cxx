@@ -0,0 +1,227 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* headless address symbolizer - translates addresses to source code coordinates, in the spirit of 'addr2line'
+ *
+ * usage: troll-symbolize [--cfa] [--chunk=n] elf-file [address-file]
+ *
+ * the addresses are read from 'address-file', or from the standard input if no file is given; the addresses
+ * are hexadecimal numbers (the '0x' prefix is optional), separated by whitespace; for each address, a line
+ * with these tab-separated fields is written to the standard output:
+ *	- the address
+ *	- the name of the (non-inlined) subprogram containing the address
+ *	- the file name and line number for the address
+ *	- the inlining chain, innermost inlined subroutine first, each entry in the form 'name@call-file:call-line',
+ *	  the entries separated by ' < '; a '-' is printed if the address is not in an inlined subroutine
+ *	- the sforth code for computing the frame base of the subprogram
+ *	- only when the '--cfa' option is given, the sforth unwind code for the address, from the .debug_frame section
+ * unknown values are printed as '??'
+ *
+ * the debug information index is built only once, when the elf file is loaded, and the input is processed
+ * in chunks of addresses (65536 by default), so that the line number program of each compilation unit is
+ * run at most once for each chunk */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unordered_map>
+#include "debug-sections.hxx"
+
+/* the sforth code strings generated by libtroll usually end with a space */
+static std::string trimmed(std::string s)
+{
+	while (s.size() && isspace((unsigned char) s.back()))
+		s.pop_back();
+	return s;
+}
+
+class Symbolizer
+{
+private:
+	DwarfData	* dwdata;
+	/* this is null if the elf file has no .debug_frame section */
+	DwarfUnwinder	* dwundwind;
+	bool		is_cfa_printed;
+	/* caches, keyed by die offsets - the frame base code for subprograms, and the descriptions of inlined subroutines */
+	std::unordered_map<uint32_t, std::string>	frame_bases, inlined_subroutines;
+	std::string	output;
+
+	const std::string & frameBase(const struct DwarfData::SymbolizedAddress & s)
+	{
+		auto x = frame_bases.find(s.subprogram.offset);
+		if (x != frame_bases.end())
+			return x->second;
+		/* the frame base is usually an attribute of the subprogram itself; only read the whole execution
+		 * context when it is not - this is much slower */
+		int node = dwdata->contextNodeForAddress(s.coordinates.address);
+		while (dwdata->contextNode(node).parent != -1)
+			node = dwdata->contextNode(node).parent;
+		std::string frame_base = dwdata->locationSforthCode(s.subprogram, dwdata->contextNode(node).die(), -1, DW_AT_frame_base);
+		if (frame_base.empty())
+			frame_base = dwdata->sforthCodeFrameBaseForContext(dwdata->executionContextForAddress(s.coordinates.address));
+		frame_base = trimmed(frame_base);
+		return frame_bases[s.subprogram.offset] = frame_base.empty() ? "??" : frame_base;
+	}
+	const std::string & inlinedSubroutine(const struct Die & die)
+	{
+		auto x = inlined_subroutines.find(die.offset);
+		if (x != inlined_subroutines.end())
+			return x->second;
+		auto call_site = dwdata->sourceCodeCoordinatesForDieOffset(die.offset);
+		std::string s = std::string(dwdata->nameOfDie(die)) + "@";
+		if (call_site.call_line != -1)
+			s += std::string(call_site.call_file_name) + ":" + std::to_string(call_site.call_line);
+		else
+			s += "??";
+		return inlined_subroutines[die.offset] = s;
+	}
+public:
+	Symbolizer(DwarfData * dwdata, DwarfUnwinder * dwundwind, bool is_cfa_printed)
+	{ this->dwdata = dwdata, this->dwundwind = dwundwind, this->is_cfa_printed = is_cfa_printed; }
+	void symbolize(const std::vector<uint32_t> & addresses)
+	{
+		int i, j;
+		char address[16];
+		auto results = dwdata->sourceCodeCoordinatesForAddresses(addresses);
+		output.clear();
+		for (i = 0; i < results.size(); i ++)
+		{
+			const struct DwarfData::SymbolizedAddress & s(results.at(i));
+			snprintf(address, sizeof address, "0x%08x", (unsigned) addresses.at(i));
+			output += address;
+			output += '\t';
+			output += s.subprogram.offset ? s.subprogram_name : "??";
+			output += '\t';
+			if (s.coordinates.line != -1)
+				output += std::string(s.coordinates.file_name) + ":" + std::to_string(s.coordinates.line);
+			else
+				output += "??:0";
+			output += '\t';
+			if (s.inlining_chain.empty())
+				output += '-';
+			for (j = 0; j < s.inlining_chain.size(); j ++)
+			{
+				if (j)
+					output += " < ";
+				output += inlinedSubroutine(s.inlining_chain.at(j));
+			}
+			output += '\t';
+			output += s.subprogram.offset ? frameBase(s) : "??";
+			if (is_cfa_printed)
+			{
+				auto cfa = dwundwind ? dwundwind->sforthCodeForAddress(addresses.at(i)) : std::pair<std::string, uint32_t>("", -1);
+				output += '\t';
+				output += cfa.second == -1 ? "??" : trimmed(cfa.first);
+			}
+			output += '\n';
+		}
+		fwrite(output.data(), 1, output.size(), stdout);
+	}
+};
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: troll-symbolize [--cfa] [--chunk=n] elf-file [address-file]\n");
+	exit(1);
+}
+
+int main(int argc, char * argv[])
+{
+	const char * elf_filename = 0, * address_filename = 0;
+	bool is_cfa_printed = false;
+	int i, chunk_size = 65536;
+	FILE * input = stdin;
+
+	for (i = 1; i < argc; i ++)
+	{
+		if (!strcmp(argv[i], "--cfa"))
+			is_cfa_printed = true;
+		else if (!strncmp(argv[i], "--chunk=", strlen("--chunk=")))
+		{
+			if ((chunk_size = atoi(argv[i] + strlen("--chunk="))) <= 0)
+				usage();
+		}
+		else if (!elf_filename)
+			elf_filename = argv[i];
+		else if (!address_filename)
+			address_filename = argv[i];
+		else
+			usage();
+	}
+	if (!elf_filename)
+		usage();
+
+	struct DebugSections sections;
+	std::string error = sections.load(elf_filename);
+	if (!error.empty())
+	{
+		fprintf(stderr, "troll-symbolize: %s\n", error.c_str());
+		return 1;
+	}
+	if (address_filename && !(input = fopen(address_filename, "r")))
+	{
+		fprintf(stderr, "troll-symbolize: cannot open file %s\n", address_filename);
+		return 1;
+	}
+
+	std::unique_ptr<DwarfData> dwdata(sections.dwarfData());
+	std::unique_ptr<DwarfUnwinder> dwundwind(is_cfa_printed && !sections.debug_frame.empty() ? sections.dwarfUnwinder() : 0);
+	Symbolizer symbolizer(dwdata.get(), dwundwind.get(), is_cfa_printed);
+	std::vector<uint32_t> addresses;
+	static char output_buffer[1 << 16];
+	char token[64];
+	int c, length = 0;
+
+	setvbuf(stdout, output_buffer, _IOFBF, sizeof output_buffer);
+	addresses.reserve(chunk_size);
+	do
+	{
+		c = getc(input);
+		if (c != EOF && !isspace(c))
+		{
+			if (length < sizeof token - 1)
+				token[length ++] = c;
+			continue;
+		}
+		if (!length)
+			continue;
+		token[length] = 0, length = 0;
+		char * end;
+		unsigned long address = strtoul(token, & end, 16);
+		if (* end)
+		{
+			fprintf(stderr, "troll-symbolize: invalid address '%s', ignored\n", token);
+			continue;
+		}
+		addresses.push_back(address);
+		if (addresses.size() == chunk_size)
+			symbolizer.symbolize(addresses), addresses.clear();
+	}
+	while (c != EOF);
+	if (addresses.size())
+		symbolizer.symbolize(addresses);
+	fflush(stdout);
+	if (input != stdin)
+		fclose(input);
+	return 0;
+}
@@ -0,0 +1,130 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#include "trace.hxx"
+#include <vector>
+#include <QMutex>
+#include <QThread>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+struct TraceThreadBuffer
+{
+	int		thread_id;
+	QByteArray	thread_name;
+	/* the total number of events ever recorded in this buffer; only the owning thread writes it */
+	std::atomic<uint64_t>	head;
+	/* incremented by 'Trace::clear()', events before this index are not exported */
+	std::atomic<uint64_t>	tail;
+	struct Trace::Event	events[Trace::RING_BUFFER_SIZE];
+	TraceThreadBuffer(int thread_id, const QByteArray & thread_name) : thread_id(thread_id), thread_name(thread_name), head(0), tail(0) {}
+};
+
+struct TraceRegistry
+{
+	QMutex	mutex;
+	std::vector<TraceThreadBuffer *>	buffers;
+};
+
+static struct TraceRegistry & registry(void)
+{
+	static TraceRegistry * r = new TraceRegistry;
+	return * r;
+}
+
+static struct TraceThreadBuffer * registerThread(void)
+{
+TraceRegistry & r(registry());
+QMutexLocker lock(& r.mutex);
+	QByteArray name = QThread::currentThread()->objectName().toUtf8();
+	if (name.isEmpty())
+		name = r.buffers.empty() ? "main" : QByteArray("thread ") + QByteArray::number((int) r.buffers.size());
+	TraceThreadBuffer * b = new TraceThreadBuffer(r.buffers.size() + 1, name);
+	r.buffers.push_back(b);
+	return b;
+}
+
+QElapsedTimer & Trace::epoch(void)
+{
+	static QElapsedTimer * e = [] (void) -> QElapsedTimer * { auto e = new QElapsedTimer; e->start(); return e; } ();
+	return * e;
+}
+
+void Trace::record(const char * name, const char * category, int64_t start, int64_t duration)
+{
+	static thread_local TraceThreadBuffer * buffer = registerThread();
+	uint64_t head = buffer->head.load(std::memory_order_relaxed);
+	struct Event & e(buffer->events[head & (RING_BUFFER_SIZE - 1)]);
+	e.name = name, e.category = category, e.start = start, e.duration = duration;
+	buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Trace::clear(void)
+{
+TraceRegistry & r(registry());
+QMutexLocker lock(& r.mutex);
+	for (auto b : r.buffers)
+		b->tail = b->head.load(std::memory_order_acquire);
+}
+
+QByteArray Trace::toChromeTraceJson(void)
+{
+TraceRegistry & r(registry());
+QMutexLocker lock(& r.mutex);
+QJsonArray events;
+	for (auto b : r.buffers)
+	{
+		QJsonObject thread_name, args;
+		args["name"] = QString::fromUtf8(b->thread_name);
+		thread_name["ph"] = "M";
+		thread_name["name"] = "thread_name";
+		thread_name["pid"] = 1;
+		thread_name["tid"] = b->thread_id;
+		thread_name["args"] = args;
+		events.append(thread_name);
+
+		uint64_t head = b->head.load(std::memory_order_acquire), i;
+		i = b->tail;
+		if (head - i > RING_BUFFER_SIZE)
+			i = head - RING_BUFFER_SIZE;
+		/*! \note	the owning thread may be overwriting the oldest events while they are exported - this
+		 *		only garbles a few spans at the very start of the trace, which is acceptable */
+		for (; i < head; i ++)
+		{
+			const struct Event & e(b->events[i & (RING_BUFFER_SIZE - 1)]);
+			QJsonObject x;
+			x["name"] = e.name;
+			x["cat"] = e.category;
+			x["ph"] = "X";
+			/* chrome trace timestamps are in microseconds */
+			x["ts"] = e.start / 1000.;
+			x["dur"] = e.duration / 1000.;
+			x["pid"] = 1;
+			x["tid"] = b->thread_id;
+			events.append(x);
+		}
+	}
+	QJsonObject trace;
+	trace["traceEvents"] = events;
+	trace["displayTimeUnit"] = "ms";
+	return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
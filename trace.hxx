@@ -0,0 +1,93 @@
+/*
+Copyright (c) 2017 stoyan shopov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+#ifndef TRACE_HXX
+#define TRACE_HXX
+
+#include <stdint.h>
+#include <atomic>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+/* lightweight tracing of the debugger internals, exported in the chrome trace event format (viewable in
+ * 'chrome://tracing', or in 'https://ui.perfetto.dev')
+ *
+ * trace spans are recorded with the 'TRACE_SPAN' macro, which times the enclosing scope:
+ *	void MainWindow::backtrace(void)
+ *	{
+ *		TRACE_SPAN("backtrace");
+ *		...
+ * the span names (and categories) must be string literals, only the pointers to them are recorded
+ *
+ * each thread records its spans in its own fixed size ring buffer, so recording needs no locking; when a
+ * ring buffer fills up, the oldest spans in it are overwritten; the ring buffers are registered globally
+ * when a thread records its first span, and are never freed, so that they can be exported after their
+ * threads have exited */
+
+#define TRACE_ENABLED		1
+
+#define TRACE_CONCATENATE_(x, y)	x ## y
+#define TRACE_CONCATENATE(x, y)		TRACE_CONCATENATE_(x, y)
+#if TRACE_ENABLED
+#define TRACE_SPAN(name)		Trace::Span TRACE_CONCATENATE(trace_span_, __LINE__)(name)
+#define TRACE_SPAN_CATEGORY(name, category)	Trace::Span TRACE_CONCATENATE(trace_span_, __LINE__)(name, category)
+#else
+#define TRACE_SPAN(name)
+#define TRACE_SPAN_CATEGORY(name, category)
+#endif
+
+class Trace
+{
+public:
+	struct Event
+	{
+		const char	* name;
+		const char	* category;
+		/* in nanoseconds, relative to the trace epoch */
+		int64_t		start;
+		int64_t		duration;
+	};
+	enum
+	{
+		/* must be a power of 2 */
+		RING_BUFFER_SIZE	= 1 << 16,
+	};
+	class Span
+	{
+	private:
+		const char	* name, * category;
+		int64_t		start;
+	public:
+		Span(const char * name, const char * category = "troll") : name(name), category(category), start(now()) {}
+		~Span(void) { record(name, category, start, now() - start); }
+	};
+	/* nanoseconds since the trace epoch - the first use of the tracing facility */
+	static int64_t now(void) { return epoch().nsecsElapsed(); }
+	static void record(const char * name, const char * category, int64_t start, int64_t duration);
+	/* discards all recorded spans */
+	static void clear(void);
+	/* returns all recorded spans, from all threads, as a chrome trace event json document */
+	static QByteArray toChromeTraceJson(void);
+private:
+	static QElapsedTimer & epoch(void);
+};
+
+#endif // TRACE_HXX
@@ -22,6 +22,7 @@ THE SOFTWARE.
 #include "troll.hxx"
 #include "ui_mainwindow.h"
 #include <QByteArray>
+#include <QDebug>
 #include <QFile>
 #include <QMessageBox>
 #include <QTime>
@@ -33,6 +34,9 @@ THE SOFTWARE.
 #include <QDir>
 #include <QTextBlock>
 #include <QFileDialog>
+#include <QJsonDocument>
+#include <algorithm>
+#include "trace.hxx"
 
 #define DEBUG_BACKTRACE		0
 
@@ -126,6 +130,7 @@ void Highlighter::highlightBlock(const QString &text)
 void MainWindow::dump_debug_tree(std::vector<struct Die> & dies, int level)
 {
 int i;
+	src.view_key.clear();
 	for (i = 0; i < dies.size(); i++)
 	{
 		ui->plainTextEdit->appendPlainText(QString(level, QChar('\t')) + QString("tag %1, @offset $%2").arg(dies.at(i).tag).arg(dies.at(i).offset, 0, 16));
@@ -249,6 +254,7 @@ QTextCharFormat cf;
 
 void MainWindow::displaySourceCodeFile(QString source_filename, QString directory_name, QString compilation_directory, int highlighted_line, uint32_t address)
 {
+	TRACE_SPAN_CATEGORY("displaySourceCodeFile", "ui");
         source_filename.replace(QChar('\\'), QChar('/'));
         directory_name.replace(QChar('\\'), QChar('/'));
         compilation_directory.replace(QChar('\\'), QChar('/'));
@@ -260,101 +266,97 @@ void MainWindow::displaySourceCodeFile(QString source_filename, QString director
 
 QTime stime;
 stime.start();
-QFile source_file;
-QString t;
 QTextBlockFormat f;
 QTextCharFormat cf;
 QTime x;
-int i, cursor_position_for_line(0);
-QFileInfo finfo(directory_name + "/" + source_filename);
-std::vector<struct DebugLine::lineAddress> line_addresses;
-std::map<uint32_t, struct DebugLine::lineAddress *> line_indices;
-
-	src.address_positions_in_document.clear();
-	src.line_positions_in_document.clear();
-
-	if (!finfo.exists())
-                finfo.setFile(compilation_directory + "/" + source_filename);
-	if (!finfo.exists())
-                finfo.setFile(compilation_directory + "/" + directory_name + "/" + source_filename);
-	ui->plainTextEdit->clear();
-	source_file.setFileName(finfo.canonicalFilePath());
-	
+int cursor_position_for_line(0);
+static Metrics::Counter & view_hits(Metrics::counter("ui.source-view-cache-hits"));
+static Metrics::Counter & view_misses(Metrics::counter("ui.source-view-cache-misses"));
+
 	x.start();
-	dwdata->addressesForFile(source_filename.toLocal8Bit().constData(), line_addresses);
-	if (/* this is not exact, which it needs not be */ x.elapsed() > profiling.max_addresses_for_file_retrieval_time)
-		profiling.max_addresses_for_file_retrieval_time = x.elapsed();
-	qDebug() << "addresses for file retrieved in " << x.elapsed() << "milliseconds";
-	qDebug() << "addresses for file count: " << line_addresses.size();
-	x.restart();
-	
-	for (i = line_addresses.size() - 1; i >= 0; i --)
+	QString path = source_files.resolvedPath(source_filename, directory_name, compilation_directory);
+	const struct SourceFileCache::SourceFile * source_file = source_files.sourceFile(path);
+	bool is_disassembly_shown = ui->actionShow_disassembly_address_ranges->isChecked();
+	/* the rendered text depends on the file and its version on disk, and on whether disassembly is shown; the
+	 * disassembly is of the elf file memory image, so it does not change while debugging */
+	QString view_key = (source_file ? path + "\n" + source_file->stamp() : source_filename + "\n-missing")
+			+ (is_disassembly_shown ? "\n+disassembly" : "");
+	std::shared_ptr<const struct SourceFileCache::RenderedView> view = source_files.renderedView(view_key);
+	if (view)
+		view_hits.increment();
+	else
 	{
-		line_addresses.at(i).next = line_indices[line_addresses.at(i).line];
-		line_indices[line_addresses.at(i).line] = & line_addresses.at(i);
-	}
+		view_misses.increment();
+		std::shared_ptr<struct SourceFileCache::RenderedView> v(new SourceFileCache::RenderedView);
+		std::vector<struct DebugLine::lineAddress> line_addresses;
+		std::map<uint32_t, struct DebugLine::lineAddress *> line_indices;
+		QString & t(v->text);
+		int i;
+		
+		dwdata->addressesForFile(source_filename.toLocal8Bit().constData(), line_addresses);
+		Metrics::histogram("ui.addresses-for-file-retrieval").record(x.elapsed() * 1000);
+		qDebug() << "addresses for file retrieved in " << x.elapsed() << "milliseconds";
+		qDebug() << "addresses for file count: " << line_addresses.size();
+		
+		for (i = line_addresses.size() - 1; i >= 0; i --)
+		{
+			line_addresses.at(i).next = line_indices[line_addresses.at(i).line];
+			line_indices[line_addresses.at(i).line] = & line_addresses.at(i);
+		}
 
-	if (source_file.open(QFile::ReadOnly))
-	{
-		int i(1);
-		struct DebugLine::lineAddress * dis;
-		while (!source_file.atEnd())
+		if (source_file)
 		{
-			src.line_positions_in_document[i] = t.length();
-			if (i == highlighted_line)
-				cursor_position_for_line = t.length();
-			t += QString("%1 %2|").arg(line_indices[i] ? '*' : ' ')
-			                .arg(i, 4, 10, QChar(' ')) + source_file.readLine().replace('\t', "        ").replace('\r', "");
-			if (ui->actionShow_disassembly_address_ranges->isChecked())
+			struct DebugLine::lineAddress * dis;
+			for (i = 1; i <= source_file->lineCount(); i ++)
 			{
-				if (0 && address == -1)
-					Util::panic();
-				dis = line_indices[i];
-				while (dis)
+				v->line_positions[i] = t.length();
+				t += QString("%1 %2|").arg(line_indices[i] ? '*' : ' ')
+						.arg(i, 4, 10, QChar(' ')) + source_file->expandedLine(i);
+				if (is_disassembly_shown)
 				{
-					//t += QString("$%1 - $%2\n").arg(dis->address, 0, 16).arg(dis->address_span, 0, 16), dis = dis->next;
-					auto x = disassembly->disassemblyForRange(dis->address, dis->address_span);
-					int i;
-					for (i = 0; i < x.size(); i ++)
+					dis = line_indices[i];
+					while (dis)
 					{
-						src.address_positions_in_document.insert(x.at(i).first, t.length());
-						if (address == x.at(i).first)
-							cursor_position_for_line = t.length();
-						t += QString(x.at(i).second).replace('\r', "") + "\n";
+						auto x = disassembly->disassemblyForRange(dis->address, dis->address_span);
+						int j;
+						for (j = 0; j < x.size(); j ++)
+						{
+							v->address_positions.insert(x.at(j).first, t.length());
+							t += QString(x.at(j).second).replace('\r', "") + "\n";
+						}
+						t += "...\n";
+						dis = dis->next;
 					}
-					t += "...\n";
-					dis = dis->next;
 				}
 			}
-			i ++;
 		}
+		else
+			t = QString("cannot open source code file ") + path;
+		source_files.insertRenderedView(view_key, view = v);
 	}
-	else
-		t = QString("cannot open source code file ") + source_file.fileName();
-	
-	ui->plainTextEdit->appendPlainText(t);
 
-#if 0
-	c.movePosition(QTextCursor::Start);
-	dis.setBackground(QBrush(Qt::lightGray));
-	i = 0;
-	while (!c.atEnd())
-	{
-		i ++;
-		if (lines[i])
-			c.setBlockFormat(dis);
-		if (!c.movePosition(QTextCursor::NextBlock))
-			break;
-	}
-#endif
+	src.line_positions_in_document = view->line_positions;
+	src.address_positions_in_document = view->address_positions;
+	if (view->line_positions.contains(highlighted_line))
+		cursor_position_for_line = view->line_positions[highlighted_line];
+	if (is_disassembly_shown && view->address_positions.contains(address))
+		cursor_position_for_line = view->address_positions[address];
+
 	QTextCursor c(ui->plainTextEdit->textCursor());
-	c.movePosition(QTextCursor::Start);
-#if 0
-	c.movePosition(QTextCursor::NextBlock, QTextCursor::MoveAnchor, ui->tableWidgetBacktrace->item(row, 3)->text().toInt() - 1);
-	qDebug() << "line" << l << "computed position" << cursor_position_for_line << "real position" << c.position() << "delta" << cursor_position_for_line - c.position();
-#else
-	c.setPosition(cursor_position_for_line);
-#endif
+	if (src.view_key != view_key)
+	{
+		ui->plainTextEdit->setPlainText(view->text);
+		src.view_key = view_key;
+	}
+	else if (src.highlighted_line_position != -1)
+	{
+		/* the view is already displayed - only remove the highlighting of the previously highlighted line */
+		c.setPosition(src.highlighted_line_position);
+		c.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+		c.setBlockFormat(QTextBlockFormat());
+		c.setCharFormat(QTextCharFormat());
+	}
+	c.setPosition(src.highlighted_line_position = cursor_position_for_line);
 	f.setBackground(QBrush(Qt::cyan));
 	cf.setForeground(QBrush(Qt::blue));
 	c.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
@@ -365,11 +367,9 @@ std::map<uint32_t, struct DebugLine::lineAddress *> line_indices;
 	c.setCharFormat(cf);
 	ui->plainTextEdit->setTextCursor(c);
 	ui->plainTextEdit->centerCursor();
-	if (/* this is not exact, which it needs not be */ x.elapsed() > profiling.max_source_code_view_build_time)
-		profiling.max_source_code_view_build_time = x.elapsed();
+	Metrics::histogram("ui.source-code-view-build").record(x.elapsed() * 1000);
 	qDebug() << "source code view built in " << x.elapsed() << "milliseconds";
-	if (/* this is not exact, which it needs not be */ stime.elapsed() > profiling.max_context_view_generation_time)
-		profiling.max_context_view_generation_time = stime.elapsed();
+	Metrics::histogram("ui.context-view-build").record(stime.elapsed() * 1000);
 	current_source_code_file_displayed = last_source_filename = source_filename;
 	last_directory_name = directory_name;
 	last_compilation_directory = compilation_directory;
@@ -382,6 +382,7 @@ std::map<uint32_t, struct DebugLine::lineAddress *> line_indices;
 
 void MainWindow::backtrace()
 {
+	TRACE_SPAN_CATEGORY("backtrace", "ui");
 	QTime t;
 	struct Die call_site;
 	t.start();
@@ -389,7 +390,7 @@ void MainWindow::backtrace()
 	register_cache.clear();
 	register_cache.pushFrame(cortexm0->getRegisters());
 	uint32_t last_pc, last_stack_pointer;
-	auto context = dwdata->executionContextForAddress(last_pc = cortexm0->programCounter());
+	auto context = dwdata->programCounterContext(last_pc = cortexm0->programCounter()).context;
 	last_stack_pointer = cortexm0->stackPointerValue();
 	int row;
 	
@@ -401,9 +402,28 @@ void MainWindow::backtrace()
 	{
 		auto subprogram = dwdata->topLevelSubprogramOfContext(context);
 		auto unwind_data = dwundwind->sforthCodeForAddress(cortexm0->programCounter());
-		auto x = dwdata->sourceCodeCoordinatesForAddress(cortexm0->programCounter());
+		const auto & pc_context = dwdata->programCounterContext(cortexm0->programCounter());
+		auto x = pc_context.coordinates;
+		auto frame_base_sforth_code = pc_context.frame_base_sforth_code;
 		row = ui->tableWidgetBacktrace->rowCount();
-		if (row) ui->tableWidgetBacktrace->setItem(row - 1, 8, new QTableWidgetItem(dwdata->callSiteAtAddress(cortexm0->programCounter(), call_site) ? "yes" : "no"));
+		if (row)
+		{
+			QString call_site_text("no");
+			if (dwdata->callSiteAtAddress(cortexm0->programCounter(), call_site))
+			{
+				/* annotate the call site with the dwarf expressions (shown as sforth code, not evaluated) that compute,
+				 * in the frame of the caller, the values of the parameters passed in registers */
+				call_site_text = "yes";
+				auto parameters = dwdata->callSiteParametersAtAddress(cortexm0->programCounter());
+				for (const auto & parameter : parameters)
+				{
+					auto value = QString::fromStdString(dwdata->callSiteParameterValueSforthCode(parameter)).trimmed();
+					if (parameter.register_number != -1 && !value.isEmpty())
+						call_site_text += QString("; r%1 value expression: %2").arg(parameter.register_number).arg(value);
+				}
+			}
+			ui->tableWidgetBacktrace->setItem(row - 1, 8, new QTableWidgetItem(call_site_text));
+		}
 		if (DEBUG_BACKTRACE) qDebug() << x.file_name << (signed) x.line;
 		if (DEBUG_BACKTRACE) qDebug() << "dwarf unwind program:" << QString::fromStdString(unwind_data.first) << "address:" << unwind_data.second;
 
@@ -418,7 +438,7 @@ void MainWindow::backtrace()
 		ui->tableWidgetBacktrace->setItem(row, 4, new QTableWidgetItem(x.directory_name));
 		ui->tableWidgetBacktrace->setItem(row, 5, new QTableWidgetItem(x.compilation_directory_name));
 		ui->tableWidgetBacktrace->setItem(row, 6, new QTableWidgetItem(QString("$%1").arg(subprogram.offset, 0, 16)));
-		ui->tableWidgetBacktrace->setItem(row, 7, new QTableWidgetItem(QString::fromStdString(dwdata->sforthCodeFrameBaseForContext(context))));
+		ui->tableWidgetBacktrace->setItem(row, 7, new QTableWidgetItem(QString::fromStdString(frame_base_sforth_code)));
 		
 		int i;
 		auto inlining_chain = dwdata->inliningChainOfContext(context);
@@ -432,10 +452,10 @@ void MainWindow::backtrace()
 		}
 		
 		if (cortexm0->unwindFrame(QString::fromStdString(unwind_data.first), unwind_data.second, cortexm0->programCounter()))
-			context = dwdata->executionContextForAddress(cortexm0->programCounter()), register_cache.pushFrame(cortexm0->getRegisters());
+			context = dwdata->programCounterContext(cortexm0->programCounter()).context, register_cache.pushFrame(cortexm0->getRegisters());
 		if (context.empty() && cortexm0->architecturalUnwind())
 		{
-			context = dwdata->executionContextForAddress(cortexm0->programCounter());
+			context = dwdata->programCounterContext(cortexm0->programCounter()).context;
 			if (!context.empty())
 			{
 				if (DEBUG_BACKTRACE) qDebug() << "architecture-specific unwinding performed";
@@ -473,6 +493,7 @@ void MainWindow::backtrace()
 			t += QString(x.at(i).second).replace('\r', "") + "\n";
 		}
 		ui->plainTextEdit->setPlainText(t);
+		src.view_key.clear();
 		QTextCursor c(ui->plainTextEdit->textCursor());
 		c.setPosition(cursor_position_for_line);
 		QTextBlockFormat f;
@@ -490,8 +511,7 @@ void MainWindow::backtrace()
 
 		colorizeSourceCodeView();
 	}
-	if (/* this is not exact, which it needs not be */ t.elapsed() > profiling.max_backtrace_generation_time)
-		profiling.max_backtrace_generation_time = t.elapsed();
+	Metrics::histogram("ui.backtrace").record(t.elapsed() * 1000);
 }
 
 bool MainWindow::readElfSections(void)
@@ -573,6 +593,7 @@ int i, j;
 
 void MainWindow::updateRegisterView(void)
 {
+	TRACE_SPAN_CATEGORY("updateRegisterView", "ui");
 	for (int row(0); row < register_cache.registerCount(); row ++)
 	{
 		QString s(QString("$%1").arg(register_cache.readCachedRegister(row), 0, 16)), t = ui->tableWidgetRegisters->item(row, 1)->text();
@@ -649,24 +670,21 @@ QMap<QString, QVariant> user_data;
 	ui->treeWidgetBreakpoints->blockSignals(false);
 }
 
-static bool sortSourcefiles(const struct DebugLine::sourceFileNames & a, const struct DebugLine::sourceFileNames & b)
-{ auto x = strcmp(a.file, b.file); if (x) return x < 0; return strcmp(a.directory, b.directory) < 0; }
-
 MainWindow::MainWindow(QWidget *parent) :
 	QMainWindow(parent),
 	ui(new Ui::MainWindow)
 {
 	QTime startup_time;
 	execution_state = INVALID_EXECUTION_STATE;
+	step_range_start = step_range_end = 0;
 	int i;
 	QCoreApplication::setOrganizationName("shopov instruments");
 	QCoreApplication::setApplicationName("troll");
 	QSettings s("troll.rc", QSettings::IniFormat);
-	memset(& profiling, 0, sizeof profiling);
 
 	setStyleSheet("QSplitter::handle:horizontal { width: 2px; }  /*QSplitter::handle:vertical { height: 20px; }*/ "
 	              "QSplitter::handle { border: 1px solid blue; background-color: white; } "
-		      "QTableWidget::item{ selection-background-color: teal}"
+		      "QTableView::item{ selection-background-color: teal}"
  
 "QTreeView::branch:has-siblings:!adjoins-item {"
     "border-image: url(:/resources/images/stylesheet-vline.png) 0;"
@@ -774,7 +792,7 @@ there:
 				      "\n\nthe troll will now abort");
 		exit(2);
 	}
-	profiling.debug_sections_disk_read_time = t.elapsed();
+	Metrics::gauge("startup.debug-sections-disk-read-ms").set(t.elapsed());
 	
 	if (!readElfSections())
 		exit(1);
@@ -863,9 +881,25 @@ there:
 	}
 	
 	ui->plainTextEdit->appendPlainText(QString("compilation unit count in the .debug_aranges section : %1").arg(dwdata->compilation_unit_count()));
-	profiling.all_compilation_units_processing_time = t.elapsed();
-	qDebug() << "all compilation units in .debug_info processed in" << profiling.all_compilation_units_processing_time << "milliseconds";
-	dwdata->dumpStats();
+	Metrics::gauge("startup.debug-info-processing-ms").set(t.elapsed());
+	qDebug() << "all compilation units in .debug_info processed in" << t.elapsed() << "milliseconds";
+	Metrics::addCollector([this] (void) -> void
+	{
+		auto & stats(dwdata->queryStatistics());
+		Metrics::gauge("dwarf.total-dies").set(dwdata->totalDies());
+		Metrics::gauge("dwarf.total-compilation-units").set(dwdata->totalCompilationUnits());
+		Metrics::gauge("dwarf.dies-read").set(stats.dies_read);
+		Metrics::gauge("dwarf.compilation-unit-arange-hits").set(stats.compilation_unit_arange_hits);
+		Metrics::gauge("dwarf.compilation-unit-arange-misses").set(stats.compilation_unit_arange_misses);
+		Metrics::gauge("dwarf.compilation-unit-header-hits").set(stats.compilation_unit_header_hits);
+		Metrics::gauge("dwarf.compilation-unit-header-misses").set(stats.compilation_unit_header_misses);
+		Metrics::gauge("dwarf.abbreviation-hits").set(stats.abbreviation_hits);
+		Metrics::gauge("dwarf.abbreviation-misses").set(stats.abbreviation_misses);
+		Metrics::gauge("dwarf.pc-context-hits").set(stats.pc_context_hits);
+		Metrics::gauge("dwarf.pc-context-misses").set(stats.pc_context_misses);
+		Metrics::gauge("dwarf.frame-descriptor-hits").set(stats.frame_descriptor_hits);
+		Metrics::gauge("dwarf.frame-descriptor-misses").set(stats.frame_descriptor_misses);
+	});
 	
 	dwundwind = new DwarfUnwinder(debug_frame.data(), debug_frame.length());
 	while (!dwundwind->at_end())
@@ -897,13 +931,13 @@ there:
 	
 	t.restart();
 	dwdata->dumpLines();
-	profiling.debug_lines_processing_time = t.elapsed();
-	qDebug() << ".debug_lines section processed in" << profiling.debug_lines_processing_time << "milliseconds";
+	Metrics::gauge("startup.debug-lines-processing-ms").set(t.elapsed());
+	qDebug() << ".debug_lines section processed in" << t.elapsed() << "milliseconds";
 	t.restart();
 	std::vector<struct StaticObject> data_objects, subprograms;
 	dwdata->reapStaticObjects(data_objects, subprograms);
-	profiling.static_storage_duration_data_reap_time = t.elapsed();
-	qDebug() << "static storage duration data reaped in" << profiling.static_storage_duration_data_reap_time << "milliseconds";
+	Metrics::gauge("startup.static-objects-reap-ms").set(t.elapsed());
+	qDebug() << "static storage duration data reaped in" << t.elapsed() << "milliseconds";
 	qDebug() << "data objects:" << data_objects.size() << ", subprograms:" << subprograms.size();
 	t.restart();
 
@@ -939,35 +973,27 @@ there:
 	ui->tableWidgetStaticDataObjects->resizeColumnsToContents();
 	/*! \warning	resizing the rows to fit the contents can be **very** expensive */
 	//ui->tableWidgetStaticDataObjects->resizeRowsToContents();
-	profiling.static_storage_duration_display_view_build_time = t.elapsed();
-	qDebug() << "static object lists built in" << profiling.static_storage_duration_display_view_build_time << "milliseconds";
+	Metrics::gauge("startup.static-objects-view-build-ms").set(t.elapsed());
+	qDebug() << "static object lists built in" << t.elapsed() << "milliseconds";
 
-	profiling.debugger_startup_time = startup_time.elapsed();
-	qDebug() << "debugger startup time:" << profiling.debugger_startup_time << "milliseconds";
+	Metrics::gauge("startup.total-ms").set(startup_time.elapsed());
+	qDebug() << "debugger startup time:" << startup_time.elapsed() << "milliseconds";
 
 	connect(& blackstrike_port, SIGNAL(error(QSerialPort::SerialPortError)), this, SLOT(blackstrikeError(QSerialPort::SerialPortError)));
 
-	std::vector<DebugLine::sourceFileNames> sources;
-	dwdata->getFileAndDirectoryNamesPointers(sources);
-	std::sort(sources.begin(), sources.end(), sortSourcefiles);
-	int row;
-	for (row = i = 0; i < sources.size(); i ++)
-	{
-		if (i && !strcmp(sources.at(i).file, sources.at(i - 1).file) && !strcmp(sources.at(i).directory, sources.at(i - 1).directory))
-			continue;
-		ui->tableWidgetFiles->insertRow(row);
-		ui->tableWidgetFiles->setItem(row, 0, new QTableWidgetItem(sources.at(i).file));
-		ui->tableWidgetFiles->setItem(row, 1, new QTableWidgetItem(sources.at(i).directory));
-		ui->tableWidgetFiles->setItem(row, 2, new QTableWidgetItem(sources.at(i).compilation_directory));
-		row ++;
-	}
-	ui->tableWidgetFiles->sortItems(0);
+	ui->tableViewFiles->setModel(source_files_model = new SourceFileTableModel(dwdata->sourceFiles(), this));
+	connect(ui->tableViewFiles->selectionModel(), SIGNAL(currentRowChanged(QModelIndex,QModelIndex)), this, SLOT(sourceFileSelected(QModelIndex)));
 	
 	ui->plainTextEdit->installEventFilter(this);
+	src.highlighted_line_position = -1;
+	/* the source code view is read only - do not let the undo stack grow with each displayed source code file */
+	ui->plainTextEdit->setUndoRedoEnabled(false);
 	targetDisconnected();
 	highlighter = new Highlighter(ui->plainTextEdit->document());
 	
         connect(& polishing_timer, SIGNAL(timeout()), this, SLOT(polishSourceCodeViewOnTargetExecution()));
+	connect(& metrics_refresh_timer, SIGNAL(timeout()), this, SLOT(updateMetricsView()));
+	metrics_refresh_timer.start(1000);
         ui->plainTextEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
 }
 
@@ -984,6 +1010,7 @@ void MainWindow::on_lineEditSforthCommand_returnPressed()
 
 void MainWindow::on_tableWidgetBacktrace_itemSelectionChanged()
 {
+TRACE_SPAN_CATEGORY("frame view build", "ui");
 QTime x;
 int i;
 int row(ui->tableWidgetBacktrace->currentRow());
@@ -996,6 +1023,7 @@ ui->tableWidgetLocalVariables->setRowCount(0);
 if (!ui->tableWidgetBacktrace->item(row, 6))
 {
 	ui->plainTextEdit->setPlainText("singularity; context undefined");
+	src.view_key.clear();
 	return;
 }
 uint32_t cfa_value = (register_cache.frameCount() - 1 > frame_number) ? register_cache.readCachedRegister(/*! \todo fix this! don't hardcode it! */13, 1) : -1;
@@ -1019,20 +1047,34 @@ uint32_t pc = -1;
 	}
 
 	x.start();
-	auto context = dwdata->executionContextForAddress(pc);
-	auto locals = dwdata->localDataObjectsForContext(context);
+	const auto & pc_context = dwdata->programCounterContext(pc);
+	auto context = pc_context.context;
+	/* the names, types and location code of the local data objects are only computed once for a subprogram */
+	std::vector<const struct DwarfData::FrameLocal *> locals;
+	/* rows for inlined subroutines have no program counter value, and therefore no execution context */
+	if (!context.empty())
+		locals = dwdata->frameLocalsForContext(dwdata->frameDescriptorForContext(context), context);
 
 	ui->treeWidgetDataObjects->clear();
 
+	/* the data objects in target memory are read with a single scattered read after all locations are evaluated */
+	struct pending_data_object
+	{
+		QTreeWidgetItem				* item;
+		const struct DwarfData::DataNode	* node;
+		int					base;
+	};
+	QVector<struct pending_data_object> pending_data_objects;
+	QVector<struct Target::memory_range> ranges;
+
 	for (i = 0; i < locals.size(); i ++)
 	{
 		QString data_object_name;
 		ui->tableWidgetLocalVariables->insertRow(row = ui->tableWidgetLocalVariables->rowCount());
-		ui->tableWidgetLocalVariables->setItem(row, 0, new QTableWidgetItem(data_object_name = QString(dwdata->nameOfDie(locals.at(i)))));
-		std::vector<DwarfTypeNode> type_cache;
-		dwdata->readType(locals.at(i).offset, type_cache);
-		ui->tableWidgetLocalVariables->setItem(row, 1, new QTableWidgetItem(QString("%1").arg(dwdata->sizeOf(type_cache))));
-		locationSforthCode = QString::fromStdString(dwdata->locationSforthCode(locals.at(i), context.at(0), pc));
+		const struct DwarfData::FrameLocal & local(* locals.at(i));
+		ui->tableWidgetLocalVariables->setItem(row, 0, new QTableWidgetItem(data_object_name = QString::fromStdString(local.name)));
+		ui->tableWidgetLocalVariables->setItem(row, 1, new QTableWidgetItem(QString("%1").arg(local.size)));
+		locationSforthCode = QString::fromStdString(local.locationSforthCode(pc));
 		auto x = dwarf_evaluator->evaluateLocation(cfa_value, frameBaseSforthCode, locationSforthCode);
 		if (x.type == DwarfEvaluator::INVALID)
 			ui->tableWidgetLocalVariables->setItem(row, 2, new QTableWidgetItem("cannot evaluate"));
@@ -1056,12 +1098,12 @@ uint32_t pc = -1;
 				default: Util::panic();
 			}
 
-			struct DwarfData::DataNode node;
-			dwdata->dataForType(type_cache, node, true, 1);
+			const struct DwarfData::DataNode & node(local.data);
 			if (x.type == DwarfEvaluator::MEMORY_ADDRESS)
 			{
 				auto n = new QTreeWidgetItem(QStringList() << data_object_name);
-                                n->addChild(itemForNode(node, target->readBytes(x.value, node.bytesize, true), 0, base, ""));
+				pending_data_objects.push_back((struct pending_data_object) { .item = n, .node = & node, .base = base, });
+				ranges.push_back((struct Target::memory_range) { .address = (uint32_t) x.value, .length = (int) node.bytesize, });
 				ui->treeWidgetDataObjects->addTopLevelItem(n);
 			}
 			else if (x.type == DwarfEvaluator::REGISTER_NUMBER)
@@ -1075,14 +1117,16 @@ uint32_t pc = -1;
 		ui->tableWidgetLocalVariables->setItem(row, 3, new QTableWidgetItem(locationSforthCode));
 		if (ui->tableWidgetLocalVariables->item(row, 3)->text().isEmpty())
 			/* the data object may have been evaluated as a compile-time constant - try that */
-			ui->tableWidgetLocalVariables->item(row, 3)->setText(QString::fromStdString(dwdata->locationSforthCode(locals.at(i), context.at(0), pc, DW_AT_const_value)));
-		ui->tableWidgetLocalVariables->setItem(row, 4, new QTableWidgetItem(QString("$%1").arg(locals.at(i).offset, 0, 16)));
+			ui->tableWidgetLocalVariables->item(row, 3)->setText(QString::fromStdString(local.const_value_sforth_code));
+		ui->tableWidgetLocalVariables->setItem(row, 4, new QTableWidgetItem(QString("$%1").arg(local.die.offset, 0, 16)));
 	}
+	auto data = target->readScatter(ranges);
+	for (i = 0; i < pending_data_objects.size(); i ++)
+		pending_data_objects.at(i).item->addChild(itemForNode(* pending_data_objects.at(i).node, data.at(i), 0, pending_data_objects.at(i).base, ""));
 	ui->tableWidgetLocalVariables->resizeColumnsToContents();
 	ui->tableWidgetLocalVariables->resizeRowsToContents();
 	ui->treeWidgetDataObjects->expandToDepth(1);
-	if (/* this is not exact, which it needs not be */ x.elapsed() > profiling.max_local_data_objects_view_build_time)
-		profiling.max_local_data_objects_view_build_time = x.elapsed();
+	Metrics::histogram("ui.local-data-view-build").record(x.elapsed() * 1000);
 	qDebug() << "local data objects view built in " << x.elapsed() << "milliseconds";
 }
 
@@ -1132,26 +1176,27 @@ int i;
 			<< ui->tableWidgetBookmarks->item(i, 2)->text()
 			<< ui->tableWidgetBookmarks->item(i, 3)->text();
 	s.setValue("bookmarks", bookmarks);
+	if (breakpoint_allocator.count(BreakpointAllocator::FLASH_PATCH_BREAKPOINT))
+	{
+		/* restore the flash contents, so that the target does not halt on the patched breakpoints when running without a debugger */
+		if (execution_state != HALTED)
+		{
+			if (QMessageBox::question(0, "breakpoints patched in flash", "there are breakpoints patched in the target flash, which can only be removed "
+					"while the target is halted\n\nexit anyway, and leave the breakpoints in the flash?") != QMessageBox::Yes)
+			{
+				e->ignore();
+				return;
+			}
+		}
+		else if (!breakpoint_allocator.removeFlashPatchBreakpoints())
+			QMessageBox::critical(0, "failed to restore flash", "failed to remove the breakpoints patched in the target flash");
+	}
 	qDebug() << "";
 	qDebug() << "";
 	qDebug() << "";
-	qDebug() << "<<< profiling stats >>>";
+	qDebug() << "<<< metrics >>>";
 	qDebug() << "";
-	dwdata->dumpStats();
-	qDebug() << "frontend profiling stats (all times in milliseconds):";
-	qDebug() << "time for reading all debug sections from disk:" << profiling.debug_sections_disk_read_time;
-	qDebug() << "time for processing all of the .debug_info data:" << profiling.all_compilation_units_processing_time;
-	qDebug() << "time for processing the whole .debug_lines section:" << profiling.debug_lines_processing_time;
-	qDebug() << "time for gathering data on all static storage duration data and subprograms:" << profiling.static_storage_duration_data_reap_time;
-	qDebug() << "time for building the static storage duration data and subprograms views:" << profiling.static_storage_duration_display_view_build_time;
-	qDebug() << "!!! total debugger startup time:" << profiling.debugger_startup_time;
-	qDebug() << "maximum time for retrieving line and addresses for a source code file:" << profiling.max_addresses_for_file_retrieval_time;
-	qDebug() << "maximum time for building a source code view:" << profiling.max_source_code_view_build_time;
-	qDebug() << "maximum time for building a local data view:" << profiling.max_local_data_objects_view_build_time;
-	qDebug() << "maximum time for generating a backtrace:" << profiling.max_backtrace_generation_time;
-	qDebug() << "maximum time for generating a context view:" << profiling.max_context_view_generation_time;
-	qDebug() << "maximum time for retrieving breakpoint addresses for a source code line(filtered):" << profiling.max_time_for_retrieving_breakpoint_addresses_for_line;
-	qDebug() << "maximum time for retrieving breakpoint addresses for a source code line(unfiltered):" << profiling.max_time_for_retrieving_unfiltered_breakpoint_addresses_for_line;
+	qDebug().noquote() << QJsonDocument(Metrics::toJson()).toJson();
 	QMainWindow::closeEvent(e);
 }
 
@@ -1204,12 +1249,10 @@ static unsigned accumulator;
 						}
 						b.addresses = QVector<uint32_t>::fromStdVector(x);
 						breakpoints.addSourceCodeBreakpoint(b);
-						if (t.elapsed() > profiling.max_time_for_retrieving_breakpoint_addresses_for_line)
-							profiling.max_time_for_retrieving_breakpoint_addresses_for_line = t.elapsed();
+						Metrics::histogram("ui.breakpoint-addresses-for-line-filtered").record(t.elapsed() * 1000);
 						t.restart();
 						x = dwdata->unfilteredAddressesForFileAndLineNumber(last_source_filename.toLocal8Bit().constData(), i);
-						if (t.elapsed() > profiling.max_time_for_retrieving_unfiltered_breakpoint_addresses_for_line)
-							profiling.max_time_for_retrieving_unfiltered_breakpoint_addresses_for_line = t.elapsed();
+						Metrics::histogram("ui.breakpoint-addresses-for-line-unfiltered").record(t.elapsed() * 1000);
 						qDebug() << "total addresses:" << x.size();
 					}
 					else
@@ -1296,15 +1339,123 @@ static unsigned accumulator;
 	return result;
 }
 
+void MainWindow::syncBreakpoints(uint32_t excluded_address, bool is_warning_allowed)
+{
+	QVector<uint32_t> breakpoint_addresses;
+	int i;
+	for (i = 0; i < run_to_cursor_breakpoint_indices.size(); i ++)
+		breakpoint_addresses.push_back(breakpoints.machineAddressBreakpoints.at(run_to_cursor_breakpoint_indices.at(i)).address);
+	foreach (uint32_t address, breakpoints.enabledMachineAddressBreakpoints)
+		breakpoint_addresses.push_back(address);
+	/* a breakpoint patched in flash is never removed just to step over it - see 'releaseFlashPatchBreakpoint()' */
+	if (!breakpoint_allocator.isFlashPatched(excluded_address))
+		breakpoint_addresses.removeAll(excluded_address);
+	auto unresolved = breakpoint_allocator.sync(breakpoint_addresses);
+	std::sort(unresolved.begin(), unresolved.end());
+	if (unresolved.isEmpty())
+	{
+		unresolved_breakpoints.clear();
+		return;
+	}
+	QString s;
+	for (i = 0; i < unresolved.size(); i ++)
+		s += QString("$%1\n").arg(unresolved.at(i), 8, 16, QChar('0'));
+	if (!is_warning_allowed || unresolved == unresolved_breakpoints)
+	{
+		statusBar()->showMessage(QString("%1 breakpoint(s) not installed").arg(unresolved.size()));
+		return;
+	}
+	unresolved_breakpoints = unresolved;
+	QMessageBox::warning(0, "failed to set breakpoints", "failed to set breakpoints at addresses:\n" + s + "\nthe target will run without these breakpoints"
+			"\n\n(breakpoints that do not fit in the hardware breakpoint comparators can be installed by patching flash, by setting"
+			" 'flash-patch-breakpoints-enabled' to 'true' in file 'troll.rc' - note that this wears the flash)");
+}
+
+bool MainWindow::releaseFlashPatchBreakpoint(uint32_t address)
+{
+	int i;
+	if (!breakpoint_allocator.isFlashPatched(address))
+		return true;
+	if (QMessageBox::question(0, "breakpoint patched in flash", QString("the target is halted at a breakpoint patched in flash, at address $%1\n"
+			"the target cannot run past this breakpoint, unless it is removed from flash\n\n"
+			"disable the breakpoint, and continue?").arg(address, 8, 16, QChar('0'))) != QMessageBox::Yes)
+		return false;
+	for (i = 0; i < breakpoints.sourceCodeBreakpoints.size(); i ++)
+		if (breakpoints.sourceCodeBreakpoints.at(i).addresses.contains(address))
+			breakpoints.setSourceBreakpointAtIndexEnabled(i, false);
+	if ((i = breakpoints.machineBreakpointIndex(address)) != -1)
+		breakpoints.setMachineBreakpointAtIndexEnabled(i, false);
+	updateBreakpointsView();
+	colorizeSourceCodeView();
+	return true;
+}
+
+void MainWindow::removeRunToCursorBreakpoints(void)
+{
+	int i;
+	/* remove the run to cursor breakpoints, highest index first, so that the indices of the remaining ones stay valid */
+	std::sort(run_to_cursor_breakpoint_indices.begin(), run_to_cursor_breakpoint_indices.end());
+	for (i = run_to_cursor_breakpoint_indices.size() - 1; i >= 0; breakpoints.removeMachineAddressBreakpointAtIndex(run_to_cursor_breakpoint_indices.at(i --)));
+	run_to_cursor_breakpoint_indices.clear();
+}
+
 void MainWindow::on_actionSingle_step_triggered()
 {
+	/*! \todo	this is evil, make this portable */
+	uint32_t pc = target->readRawUncachedRegister(15) &~ 1;
+	if (!releaseFlashPatchBreakpoint(pc))
+		return;
 	execution_state = FREE_RUNNING;
+	/* a breakpoint at the current program counter would halt the target again without executing the instruction */
+	syncBreakpoints(pc);
 	target->requestSingleStep();
 }
 
 void MainWindow::on_actionSource_step_triggered()
 {
+	sourceStep(true);
+}
+
+void MainWindow::sourceStep(bool is_breakpoint_warning_allowed)
+{
+static Metrics::Counter & range_steps(Metrics::counter("stepping.range-steps"));
+static Metrics::Counter & breakpoint_range_steps(Metrics::counter("stepping.breakpoint-range-steps"));
+static Metrics::Counter & instruction_steps(Metrics::counter("stepping.instruction-steps"));
+QVector<uint32_t> exits, indirect_branches;
+	/*! \todo	this is evil, make this portable */
+	uint32_t pc = target->readRawUncachedRegister(15) &~ 1;
+	if (!releaseFlashPatchBreakpoint(pc))
+	{
+		execution_state = HALTED;
+		return;
+	}
 	execution_state = SOURCE_LEVEL_SINGLE_STEPPING;
+	/* step over the whole address range of the current source code line, instead of instruction by instruction */
+	if (!dwdata->lineAddressRangeForAddress(pc, step_range_start, step_range_end) || !(step_range_start <= pc && pc < step_range_end))
+		step_range_start = step_range_end = 0;
+	else
+	{
+		syncBreakpoints(pc, is_breakpoint_warning_allowed);
+		/* the breakpoints are synchronized again below, if falling back to instruction stepping - warn at most once */
+		is_breakpoint_warning_allowed = false;
+		if (target->requestRangeStep(step_range_start, step_range_end))
+		{
+			range_steps.increment();
+			return;
+		}
+		/* plant temporary breakpoints on all exits from the range, and on the indirect branches in the range - these
+		 * are single stepped, as their targets are not known in advance; the temporary breakpoints only use free
+		 * comparators, so that they do not displace the user breakpoints */
+		if (disassembly->rangeExits(step_range_start, step_range_end, target, exits, indirect_branches) && !indirect_branches.contains(pc)
+			&& breakpoint_allocator.installTemporaryBreakpoints(exits + indirect_branches))
+		{
+			breakpoint_range_steps.increment();
+			target->resume();
+			return;
+		}
+	}
+	instruction_steps.increment();
+	syncBreakpoints(pc, is_breakpoint_warning_allowed);
 	target->requestSingleStep();
 }
 
@@ -1333,7 +1484,21 @@ class Target * t;
 						continue;
 					}
 				}
-				cortexm0->setTargetController(target = t);
+				/* target memory read while the target is halted is cached */
+				auto memory_cache = new TargetMemoryCache(t);
+				/* the flash ranges that the target may modify are listed in the settings file, as 'address>length' hexadecimal pairs */
+				QStringList volatile_flash_ranges(QSettings("troll.rc", QSettings::IniFormat).value("volatile-flash-ranges").toStringList());
+				for (int j = 0; j < volatile_flash_ranges.size(); j ++)
+				{
+					auto x = volatile_flash_ranges.at(j).split('>');
+					if (x.size() == 2)
+						memory_cache->addVolatileFlashRange(x.at(0).toUInt(0, 16), x.at(1).toUInt(0, 16));
+				}
+				cortexm0->setTargetController(target = memory_cache);
+				breakpoint_allocator.setTarget(target);
+				/* installing breakpoints by patching flash wears the flash, and leaves the breakpoints in the flash if
+				 * the debugger exits abnormally - so this must be explicitly enabled in the settings file */
+				breakpoint_allocator.setFlashPatchingEnabled(QSettings("troll.rc", QSettings::IniFormat).value("flash-patch-breakpoints-enabled", false).toBool());
 				connect(target, SIGNAL(targetHalted(TARGET_HALT_REASON)), this, SLOT(targetHalted(TARGET_HALT_REASON)));
 				connect(target, SIGNAL(targetRunning()), this, SLOT(targetRunning()));
 				targetConnected();
@@ -1430,8 +1595,8 @@ bool hack_mode(ui->actionHack_mode->isChecked());
 	ui->tableWidgetFunctions->setColumnHidden(2, !hack_mode);
 	ui->tableWidgetFunctions->setColumnHidden(3, !hack_mode);
 	
-	ui->tableWidgetFiles->setColumnHidden(1, !hack_mode);
-	ui->tableWidgetFiles->setColumnHidden(2, !hack_mode);
+	ui->tableViewFiles->setColumnHidden(1, !hack_mode);
+	ui->tableViewFiles->setColumnHidden(2, !hack_mode);
 	
 	ui->actionHack_mode->setText(!hack_mode ? "to hack mode" : "to user mode");
 }
@@ -1492,17 +1657,22 @@ void MainWindow::on_comboBoxDataDisplayNumericBase_currentIndexChanged(int index
 
 void MainWindow::on_actionResume_triggered()
 {
-auto breakpointed_addresses = breakpoints.enabledMachineAddressBreakpoints.constBegin();
-
-	while (breakpointed_addresses != breakpoints.enabledMachineAddressBreakpoints.constEnd())
+	/*! \todo	this is evil, make this portable */
+	uint32_t pc = target->readRawUncachedRegister(15) &~ 1;
+	if (!releaseFlashPatchBreakpoint(pc))
 	{
-		if (!target->breakpointSet(* breakpointed_addresses, 2))
-		{
-			QMessageBox::critical(0, "failed to set breakpoint", "failed to set breakpoint!\ntoo many breakpoints requested?");
-			Util::panic();
-		}
-		breakpointed_addresses ++;
+		removeRunToCursorBreakpoints();
+		return;
+	}
+	if (breakpoint_allocator.isInstalled(pc))
+	{
+		/* step over the breakpoint at the current program counter first - the target is resumed when the step completes */
+		syncBreakpoints(pc);
+		execution_state = STEPPING_OVER_BREAKPOINT;
+		target->requestSingleStep();
+		return;
 	}
+	syncBreakpoints();
 	execution_state = FREE_RUNNING;
 	target->resume();
 }
@@ -1518,12 +1688,12 @@ void MainWindow::on_actionRead_state_triggered()
 		backtrace();
 }
 
-void MainWindow::on_tableWidgetFiles_itemSelectionChanged()
+void MainWindow::sourceFileSelected(const QModelIndex & index)
 {
-int row(ui->tableWidgetFiles->currentRow());
-	displaySourceCodeFile(ui->tableWidgetFiles->item(row, 0)->text(),
-		ui->tableWidgetFiles->item(row, 1)->text(),
-		ui->tableWidgetFiles->item(row, 2)->text(), 0);
+	if (!index.isValid())
+		return;
+	const struct DebugLine::sourceFileNames & f(source_files_model->sourceFile(index.row()));
+	displaySourceCodeFile(f.file, f.directory, f.compilation_directory, 0);
 }
 
 void MainWindow::on_actionShow_disassembly_address_ranges_triggered()
@@ -1563,10 +1733,7 @@ int row(ui->tableWidgetFunctions->currentRow());
 
 void MainWindow::targetHalted(TARGET_HALT_REASON reason)
 {
-auto breakpointed_addresses = breakpoints.enabledMachineAddressBreakpoints.constBegin();
-int i;
-
-	for (i = 0; i < run_to_cursor_breakpoint_indices.size(); breakpoints.removeMachineAddressBreakpointAtIndex(run_to_cursor_breakpoint_indices.front()), run_to_cursor_breakpoint_indices.pop_front(), i ++);
+TRACE_SPAN_CATEGORY("target halted", "ui");
 
 	switch (execution_state)
 	{
@@ -1576,9 +1743,28 @@ int i;
 			auto x = target->readRawUncachedRegister(15) &~ 1;
 			bool is_statement;
 			dwdata->sourceCodeCoordinatesForAddress(x, & is_statement);
-			if (!is_statement)
+			/* continue stepping if still inside the source code line being stepped (after single stepping an instruction),
+			 * unless halted at a breakpoint, or if not at the start of a statement */
+			if ((step_range_start <= x && x < step_range_end && !breakpoints.enabledMachineAddressBreakpoints.contains(x)) || !is_statement)
 			{
-				on_actionSource_step_triggered();
+				sourceStep(false);
+				/* stepping is not continued if the user declines to disable a breakpoint patched in flash */
+				if (execution_state == SOURCE_LEVEL_SINGLE_STEPPING)
+					return;
+			}
+		}
+		break;
+		case STEPPING_OVER_BREAKPOINT:
+		{
+			/* resume, unless the step halted the target at another breakpoint */
+			/*! \todo	this is evil, make this portable */
+			auto x = target->readRawUncachedRegister(15) &~ 1;
+			if (!breakpoints.enabledMachineAddressBreakpoints.contains(x))
+			{
+				execution_state = FREE_RUNNING;
+				/* any breakpoints that cannot be installed were already warned about when resuming */
+				syncBreakpoints(-1, false);
+				target->resume();
 				return;
 			}
 		}
@@ -1586,12 +1772,8 @@ int i;
 		case FREE_RUNNING:
 			break;
 	}
+	removeRunToCursorBreakpoints();
 	execution_state = HALTED;
-	while (breakpointed_addresses != breakpoints.enabledMachineAddressBreakpoints.constEnd())
-	{
-		target->breakpointClear(* breakpointed_addresses, 2);
-		breakpointed_addresses ++;
-	}
 	polishing_timer.stop();
 	switchActionOff(ui->actionBlackstrikeConnect);
 	switchActionOn(ui->actionSingle_step);
@@ -1638,12 +1820,17 @@ static int i;
 		i = 0;
 	polishing_timer.setInterval(200);
 	ui->plainTextEdit->setPlainText(QString("target running...") + QString(i, QChar('.')));;
+	src.view_key.clear();
 	/*! \todo	WARNING - it seems that I am doing something wrong with the 'readyRead()' signal;
 	 *		without the call to 'waitForReadyRead()' below, on one machine that I am testing on,
 	 *		incoming data from the blackmagic probe sometimes does not cause the 'readyRead()'
 	 *		signal to be emitted, which breaks the code badly; I discovered through trial and
-	 *		error that the call to 'WaitForReadyRead()' function below seems to work around this issue */
-	blackstrike_port.waitForReadyRead(1);
+	 *		error that the call to 'WaitForReadyRead()' function below seems to work around this issue;
+	 *		the blackmagic backend closes this port and does its input/output in a separate thread,
+	 *		so the port is only open here when the blackstrike backend is in use, which still
+	 *		detects target halts through the 'readyRead()' signal of this port */
+	if (blackstrike_port.isOpen())
+		blackstrike_port.waitForReadyRead(1);
 }
 
 void MainWindow::targetRunning()
@@ -1657,6 +1844,7 @@ void MainWindow::targetRunning()
 	switchActionOff(ui->actionRead_state);
 	switchActionOff(ui->actionCore_dump);
 	polishing_timer.start(500);
+	cortexm0->invalidateStackWindow();
 	ui->tableWidgetBacktrace->setRowCount(0);
 	ui->tableWidgetLocalVariables->setRowCount(0);
 }
@@ -1811,6 +1999,52 @@ void MainWindow::on_actionRun_dwarf_tests_triggered()
 	dwdata->runTests();
 }
 
+void MainWindow::updateMetricsView(void)
+{
+	if (!ui->dockWidgetMetrics->isVisible())
+		return;
+	auto metrics = Metrics::snapshot();
+	int i;
+	/* the metrics are only ever added, and are sorted by name, so existing items can be reused */
+	if (ui->treeWidgetMetrics->topLevelItemCount() != metrics.size())
+	{
+		ui->treeWidgetMetrics->clear();
+		for (i = 0; i < metrics.size(); i ++)
+			ui->treeWidgetMetrics->addTopLevelItem(new QTreeWidgetItem(QStringList() << metrics.at(i).name));
+	}
+	for (i = 0; i < metrics.size(); i ++)
+		ui->treeWidgetMetrics->topLevelItem(i)->setText(1, metrics.at(i).value);
+	ui->treeWidgetMetrics->resizeColumnToContents(0);
+}
+
+void MainWindow::on_actionExport_metrics_triggered()
+{
+	QString filename = QFileDialog::getSaveFileName(this, "export metrics", "troll-metrics.json", "json files (*.json)");
+	if (filename.isEmpty())
+		return;
+	QFile f(filename);
+	if (!f.open(QFile::WriteOnly))
+	{
+		QMessageBox::critical(0, "error writing metrics file", "cannot open file " + filename + " for writing");
+		return;
+	}
+	f.write(QJsonDocument(Metrics::toJson()).toJson());
+}
+
+void MainWindow::on_actionExport_trace_triggered()
+{
+	QString filename = QFileDialog::getSaveFileName(this, "export trace", "troll-trace.json", "json files (*.json)");
+	if (filename.isEmpty())
+		return;
+	QFile f(filename);
+	if (!f.open(QFile::WriteOnly))
+	{
+		QMessageBox::critical(0, "error writing trace file", "cannot open file " + filename + " for writing");
+		return;
+	}
+	f.write(Trace::toChromeTraceJson());
+}
+
 void MainWindow::on_treeWidgetBreakpoints_itemDoubleClicked(QTreeWidgetItem *item, int column)
 {
 QMap<QString, QVariant> x = item->data(0, Qt::UserRole).toMap();
@@ -24,11 +24,13 @@ THE SOFTWARE.
 
 #include <QMainWindow>
 #include <QTreeWidget>
+#include <QAbstractTableModel>
 #include "libtroll.hxx"
 #include "sforth.hxx"
 #include "target-corefile.hxx"
 #include "blackstrike.hxx"
 #include "blackmagic.hxx"
+#include "target-memory-cache.hxx"
 #include "cortexm0.hxx"
 #include "dwarf-evaluator.hxx"
 #include "registercache.hxx"
@@ -38,6 +40,9 @@ THE SOFTWARE.
 #include "s-record.hxx"
 #include "disassembly.hxx"
 #include "breakpoint-cache.hxx"
+#include "breakpoint-allocator.hxx"
+#include "metrics.hxx"
+#include "source-file-cache.hxx"
 #include <elfio/elfio.hpp>
 
 enum
@@ -79,6 +84,43 @@ private:
 	QTextCharFormat functionFormat;
 };
 
+/* a read only model of the source file table of the debug information; the table in the 'DwarfData' object
+ * is already free of duplicates and sorted, and is used directly, without copying */
+class SourceFileTableModel : public QAbstractTableModel
+{
+private:
+	const std::vector<struct DebugLine::sourceFileNames> & files;
+public:
+	SourceFileTableModel(const std::vector<struct DebugLine::sourceFileNames> & files, QObject * parent = 0) : QAbstractTableModel(parent), files(files) {}
+	const struct DebugLine::sourceFileNames & sourceFile(int row) const { return files.at(row); }
+	int rowCount(const QModelIndex & parent = QModelIndex()) const override { return parent.isValid() ? 0 : files.size(); }
+	int columnCount(const QModelIndex & parent = QModelIndex()) const override { return parent.isValid() ? 0 : 3; }
+	QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const override
+	{
+		if (!index.isValid() || role != Qt::DisplayRole)
+			return QVariant();
+		const struct DebugLine::sourceFileNames & f(files.at(index.row()));
+		switch (index.column())
+		{
+			case 0: return QString(f.file);
+			case 1: return QString(f.directory);
+			case 2: return QString(f.compilation_directory);
+		}
+		return QVariant();
+	}
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override
+	{
+		if (orientation == Qt::Horizontal && role == Qt::DisplayRole)
+			switch (section)
+			{
+				case 0: return QString("file");
+				case 1: return QString("directory");
+				case 2: return QString("compile directory");
+			}
+		return QAbstractTableModel::headerData(section, orientation, role);
+	}
+};
+
 class MainWindow : public QMainWindow
 {
 	Q_OBJECT
@@ -95,6 +137,8 @@ class MainWindow : public QMainWindow
 	
 	void dump_debug_tree(std::vector<struct Die> & dies, int level);
 	QTimer		polishing_timer;
+	/* periodically refreshes the metrics view, while it is visible */
+	QTimer		metrics_refresh_timer;
 	DwarfData * dwdata;
 	Disassembly 	* disassembly;
 	Highlighter	* highlighter;
@@ -105,6 +149,7 @@ class MainWindow : public QMainWindow
 	CortexM0	* cortexm0;
 	DwarfEvaluator	* dwarf_evaluator;
 	Memory		target_memory_contents;
+	SourceFileTableModel	* source_files_model;
 	BreakpointCache	breakpoints;
 	
 	struct SourceCodeDisplayData
@@ -112,8 +157,14 @@ class MainWindow : public QMainWindow
 		//QVector<uint32_t> enabled_breakpoint_positions, disabled_breakpoint_positions;
 		QMap<uint32_t /* address */, int /* line position in text document */> address_positions_in_document;
 		QMap<int /* line number */, int /* line position in text document */> line_positions_in_document;
+		/* the key of the source code view in the source file cache, if the text document holds a cached view, or an empty
+		 * string; when the same view is displayed again, only the highlighted line is moved */
+		QString	view_key;
+		/* the position in the text document of the highlighted line, or -1 */
+		int	highlighted_line_position;
 	}
 	src;
+	SourceFileCache	source_files;
 public:
 	struct TreeWidgetNodeData
 	{
@@ -138,6 +189,27 @@ private:
 	void dumpData(uint32_t address, const QByteArray & data);
 	void updateBreakpointsView(void);
 	QVector<int> run_to_cursor_breakpoint_indices;
+	/* the breakpoints installed in the target; these stay installed while the target is halted, and only
+	 * the differences to the enabled breakpoints are sent to the target before it is run */
+	BreakpointAllocator breakpoint_allocator;
+	/* installs the enabled breakpoints, except for a breakpoint at the address passed (if any); run to
+	 * cursor breakpoints take precedence over the other breakpoints; a warning is displayed for the
+	 * breakpoints that cannot be installed, but only if 'is_warning_allowed' is true, and the breakpoints
+	 * that cannot be installed are not the ones last warned about - otherwise, the warning is only shown
+	 * in the status bar */
+	void syncBreakpoints(uint32_t excluded_address = -1, bool is_warning_allowed = true);
+	/* the breakpoints that could not be installed, that were last warned about */
+	QVector<uint32_t> unresolved_breakpoints;
+	/* steps a source code line; 'is_breakpoint_warning_allowed' is false when continuing a source level
+	 * step after the target halted, so that stepping does not pop up warnings for each stepped instruction */
+	void sourceStep(bool is_breakpoint_warning_allowed);
+	/* the target cannot run past a breakpoint patched in flash, without reprogramming the flash; rather than removing and
+	 * patching the breakpoint again each time the target is run past it, the user is asked to disable the breakpoint at
+	 * the address passed (if it is patched in flash); returns false if the user declines, and the target must not be run */
+	bool releaseFlashPatchBreakpoint(uint32_t address);
+	void removeRunToCursorBreakpoints(void);
+	/* the address range of the source code line being stepped, when source level single stepping */
+	uint32_t step_range_start, step_range_end;
 	void colorizeSourceCodeView(void);
 
 	enum
@@ -146,6 +218,9 @@ private:
 		FREE_RUNNING,
 		HALTED,
 		SOURCE_LEVEL_SINGLE_STEPPING,
+		/* single stepping over a breakpoint at the current program counter, with that breakpoint removed,
+		 * before resuming the target */
+		STEPPING_OVER_BREAKPOINT,
 	}
 	execution_state;
 
@@ -184,7 +259,7 @@ private slots:
 	
 	void on_actionRead_state_triggered();
 	
-	void on_tableWidgetFiles_itemSelectionChanged();
+	void sourceFileSelected(const QModelIndex & index);
 	
 	void on_actionShow_disassembly_address_ranges_triggered();
 	
@@ -197,6 +272,7 @@ private slots:
 	void targetDisconnected(void);
 	void targetConnected(void);
 	void polishSourceCodeViewOnTargetExecution(void);
+	void updateMetricsView(void);
 
 	void on_treeWidgetDataObjects_itemActivated(QTreeWidgetItem *item, int column);
 	
@@ -224,6 +300,10 @@ private slots:
 	
 	void on_actionRun_dwarf_tests_triggered();
 	
+	void on_actionExport_metrics_triggered();
+	
+	void on_actionExport_trace_triggered();
+	
 	void on_treeWidgetBreakpoints_itemDoubleClicked(QTreeWidgetItem *item, int column);
 	
 	void on_treeWidgetBreakpoints_itemChanged(QTreeWidgetItem *item, int column);
@@ -235,24 +315,6 @@ protected:
 private:
 	Ui::MainWindow *ui;
 	QSerialPort	blackstrike_port;
-	/* all times are in milliseconds */
-	struct
-	{
-		unsigned	debug_sections_disk_read_time;
-		unsigned	all_compilation_units_processing_time;
-		unsigned	debug_lines_processing_time;
-		unsigned	static_storage_duration_data_reap_time;
-		unsigned	static_storage_duration_display_view_build_time;
-		unsigned	debugger_startup_time;
-		unsigned	max_backtrace_generation_time;
-		unsigned	max_context_view_generation_time;
-		unsigned	max_addresses_for_file_retrieval_time;
-		unsigned	max_source_code_view_build_time;
-		unsigned	max_local_data_objects_view_build_time;
-		unsigned	max_time_for_retrieving_breakpoint_addresses_for_line;
-		unsigned	max_time_for_retrieving_unfiltered_breakpoint_addresses_for_line;
-	}
-	profiling;
 };
 
 Q_DECLARE_METATYPE(MainWindow::TreeWidgetNodeData)
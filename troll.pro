@@ -40,7 +40,13 @@ SOURCES +=\
     external-sources/capstone/arch/ARM/ARMInstPrinter.c \
     external-sources/capstone/arch/ARM/ARMMapping.c \
     external-sources/capstone/arch/ARM/ARMModule.c \
-    breakpoint-cache.cxx
+    breakpoint-cache.cxx \
+    metrics.cxx \
+    trace.cxx \
+    source-file-cache.cxx \
+    rsp-link.cxx \
+    target-memory-cache.cxx \
+    breakpoint-allocator.cxx
 
 HEADERS  += \
     libtroll/dwarf.h \
@@ -59,7 +65,13 @@ HEADERS  += \
     troll.hxx \
     blackmagic.hxx \
     gdb-remote.hxx \
-    breakpoint-cache.hxx
+    breakpoint-cache.hxx \
+    metrics.hxx \
+    trace.hxx \
+    source-file-cache.hxx \
+    rsp-link.hxx \
+    target-memory-cache.hxx \
+    breakpoint-allocator.hxx
 
 FORMS    += mainwindow.ui \
     notification.ui
@@ -74,3 +86,24 @@ DISTFILES += \
 
 RESOURCES += \
     resources.qrc
+
+# libtroll command line tools - plain c++ programs, that only use the dwarf engine in 'libtroll', and the
+# elfio library; they are not part of the troll build, build them on request with 'make <tool-name>'
+LIBTROLL_TOOLS_CXXFLAGS = -std=c++11 -O2 -Wno-sign-compare \
+	-I$$PWD/libtroll -I$$PWD/tools -I$$PWD/external-sources/elfio
+LIBTROLL_TOOLS_DEPENDS = $$PWD/libtroll/libtroll.cxx $$PWD/libtroll/libtroll.hxx $$PWD/tools/debug-sections.hxx
+
+libtroll_bench.target = libtroll-bench
+libtroll_bench.depends = $$PWD/tools/libtroll-bench.cxx $$LIBTROLL_TOOLS_DEPENDS
+libtroll_bench.commands = $(CXX) $$LIBTROLL_TOOLS_CXXFLAGS $$PWD/tools/libtroll-bench.cxx $$PWD/libtroll/libtroll.cxx -o libtroll-bench
+QMAKE_EXTRA_TARGETS += libtroll_bench
+
+dwarf_generator.target = dwarf-generator
+dwarf_generator.depends = $$PWD/tools/dwarf-generator.cxx $$PWD/libtroll/dwarf.h
+dwarf_generator.commands = $(CXX) -std=c++11 -O2 -I$$PWD/libtroll $$PWD/tools/dwarf-generator.cxx -o dwarf-generator
+QMAKE_EXTRA_TARGETS += dwarf_generator
+
+troll_symbolize.target = troll-symbolize
+troll_symbolize.depends = $$PWD/tools/troll-symbolize.cxx $$LIBTROLL_TOOLS_DEPENDS
+troll_symbolize.commands = $(CXX) $$LIBTROLL_TOOLS_CXXFLAGS $$PWD/tools/troll-symbolize.cxx $$PWD/libtroll/libtroll.cxx -o troll-symbolize
+QMAKE_EXTRA_TARGETS += troll_symbolize